@@ -0,0 +1,155 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QTimer>
+#include "CallExeWorker.h"
+
+CallExeWorker::CallExeWorker()
+    : process(nullptr),
+      restartScheduled(false)
+{
+
+}
+
+CallExeWorker::~CallExeWorker()
+{
+    stop();
+}
+
+void CallExeWorker::send(const QString &newCommand, const QJsonObject &record)
+{
+    // The command was changed in the settings, replace the worker
+    if(newCommand != command)
+    {
+        stop();
+        command = newCommand;
+    }
+
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+
+    if(process != nullptr && process->state() == QProcess::Running)
+    {
+        process->write(line);
+        return;
+    }
+
+    pending.append(line);
+
+    if(pending.size() > maxPendingBytes)
+    {
+        int lineEnd = pending.indexOf('\n', pending.size() - maxPendingBytes);
+        pending.remove(0, lineEnd + 1);
+        qWarning() << "Call executable worker is not running, dropped old output";
+    }
+
+    if(process != nullptr && process->state() == QProcess::Starting)
+    {
+        return;
+    }
+
+    if(restartScheduled)
+    {
+        return;
+    }
+
+    qint64 sinceLastStart = lastStart.isValid() ? lastStart.elapsed() : restartDelayMs;
+
+    if(sinceLastStart < restartDelayMs)
+    {
+        restartScheduled = true;
+        QTimer::singleShot(restartDelayMs - (int)sinceLastStart, this, &CallExeWorker::startProcess);
+    }
+    else
+    {
+        startProcess();
+    }
+}
+
+// Close the worker's stdin so that it can finish, then wait a moment before killing it.
+void CallExeWorker::stop()
+{
+    pending.clear();
+
+    if(process == nullptr)
+    {
+        return;
+    }
+
+    process->disconnect(this);
+
+    if(process->state() != QProcess::NotRunning)
+    {
+        process->closeWriteChannel();
+
+        if(!process->waitForFinished(1000))
+        {
+            process->kill();
+            process->waitForFinished(1000);
+        }
+    }
+
+    delete process;
+    process = nullptr;
+}
+
+void CallExeWorker::startProcess()
+{
+    restartScheduled = false;
+
+    if(command.isEmpty() || pending.isEmpty())
+    {
+        return;
+    }
+
+    if(process == nullptr)
+    {
+        process = new QProcess(this);
+        process->setProcessChannelMode(QProcess::ForwardedChannels);
+        connect(process, &QProcess::started, this, &CallExeWorker::processStarted);
+        connect(process, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+                this, &CallExeWorker::processFinished);
+        connect(process, &QProcess::errorOccurred, this, &CallExeWorker::processError);
+    }
+
+    lastStart.start();
+    process->start(command);
+}
+
+void CallExeWorker::processStarted()
+{
+    process->write(pending);
+    pending.clear();
+}
+
+void CallExeWorker::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    qWarning() << "Call executable worker exited:" << command
+               << "exit code" << exitCode << (exitStatus == QProcess::CrashExit ? "(crashed)" : "");
+}
+
+void CallExeWorker::processError(QProcess::ProcessError error)
+{
+    if(error == QProcess::FailedToStart)
+    {
+        qWarning() << "Call executable worker failed to start:" << command << process->errorString();
+    }
+}
@@ -0,0 +1,64 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CALL_EXE_WORKER_H
+#define CALL_EXE_WORKER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QProcess>
+#include <QString>
+
+// Persistent worker for the "call executable" output. The command is started once and
+// each OCR result is written to its stdin as one line of compact JSON:
+//   {"capture":"...","translation":"...","timestamp":"..."}
+// If the worker exits it is started again for the next result. Results that arrive while
+// the worker is starting are buffered and written once it runs.
+class CallExeWorker : public QObject
+{
+    Q_OBJECT
+public:
+    CallExeWorker();
+    ~CallExeWorker();
+
+    void send(const QString &command, const QJsonObject &record);
+    void stop();
+
+private:
+    void startProcess();
+    void processStarted();
+    void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void processError(QProcess::ProcessError error);
+
+    // Minimum time between two starts of the worker, so a failing command is not respawned in a loop
+    static const int restartDelayMs = 1000;
+
+    // Output kept while the worker is not running, older output is dropped beyond this
+    static const int maxPendingBytes = 1024 * 1024;
+
+    QProcess *process;
+    QString command;
+    QByteArray pending;
+    QElapsedTimer lastStart;
+    bool restartScheduled;
+};
+
+#endif // CALL_EXE_WORKER_H
@@ -1,4 +1,4 @@
-QT += core
+QT += core concurrent
 
 !console {
     QT += gui network texttospeech
@@ -56,6 +56,8 @@ console {
 SOURCES += main.cpp\
     Furigana.cpp \
     BoundingTextRect.cpp \
+    ConnComp.cpp \
+    DebugImageWriter.cpp \
     RunGuard.cpp \
     CommandLine.cpp \
     UtilsLang.cpp \
@@ -63,12 +65,17 @@ SOURCES += main.cpp\
     PostProcess.cpp \
     PreProcess.cpp \
     OcrEngine.cpp \
+    OcrEnginePool.cpp \
+    PixelKernels.cpp \
+    TessdataIndex.cpp \
     UtilsCommon.cpp
 
 
 HEADERS  += \
     Furigana.h \
     BoundingTextRect.h \
+    ConnComp.h \
+    DebugImageWriter.h \
     CommandLine.h \
     UtilsLang.h \
     UtilsImg.h \
@@ -76,17 +83,26 @@ HEADERS  += \
     PreProcess.h \
     PreProcessCommon.h \
     OcrEngine.h \
+    OcrEnginePool.h \
+    PixelKernels.h \
+    TessdataIndex.h \
     UtilsCommon.h
 
 !console {
     SOURCES += \
         MainWindow.cpp \
+        CallExeWorker.cpp \
+        OutputLogWriter.cpp \
         SettingsDialog.cpp \
         Settings.cpp \
         PopupDialog.cpp \
         Preview.cpp \
+        PreviewTileCache.cpp \
         SampleBox.cpp \
+        ScreenChangeDetector.cpp \
         Translate.cpp \
+        TranslateBackend.cpp \
+        TranslationCache.cpp \
         Hotkey.cpp \
         HotkeyWidget.cpp \
         CaptureBox.cpp \
@@ -98,13 +114,19 @@ HEADERS  += \
 
     HEADERS  += \
         MainWindow.h \
+        CallExeWorker.h \
+        OutputLogWriter.h \
         RunGuard.h \
         SettingsDialog.h \
         Preview.h \
+        PreviewTileCache.h \
         Settings.h \
         PopupDialog.h \
         SampleBox.h \
+        ScreenChangeDetector.h \
         Translate.h \
+        TranslateBackend.h \
+        TranslationCache.h \
         Hotkey.h \
         HotkeyWidget.h \
         CaptureBox.h \
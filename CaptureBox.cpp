@@ -17,9 +17,11 @@ You should have received a copy of the GNU General Public License
 along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <QMutexLocker>
 #include "CaptureBox.h"
 #include "KeyboardHook.h"
 #include "MouseHook.h"
+#include "UtilsImg.h"
 
 CaptureBox::CaptureBox()
     : QWidget(0, Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint | Qt::Dialog | Qt::Tool),
@@ -31,7 +33,8 @@ CaptureBox::CaptureBox()
       captureModeLastPt(-1, -1),
       timerUpdateCaptureMode(this),
       autoCaptureTimer(this),
-      moveTimer(this)
+      moveTimer(this),
+      useFrozenFrame(false)
 {
     setAttribute(Qt::WA_TranslucentBackground);
 
@@ -59,6 +62,18 @@ void CaptureBox::startCaptureMode()
     KeyboardHook::getInstance().addHotkey(UP, Hotkey("Up"));
     KeyboardHook::getInstance().addHotkey(DOWN, Hotkey("Down"));
 
+    // Grab the screen before the capture box is shown so that it is not part of the frame
+    if(useFrozenFrame)
+    {
+        QImage frame = UtilsImg::takeVirtualDesktopScreenshot();
+        QMutexLocker locker(&frozenFrameMutex);
+        frozenFrame = frame;
+    }
+    else
+    {
+        releaseFrozenFrame();
+    }
+
     QPoint startPt = QCursor::pos();
     QPoint windowStartPt = startPt;
 
@@ -91,6 +106,20 @@ void CaptureBox::endCaptureMode()
     hide();
 }
 
+// Get the screen contents grabbed when capture mode started. Returns a null image if
+// frozen frame mode is off or the frame was released. Safe to call from any thread.
+QImage CaptureBox::getFrozenFrame()
+{
+    QMutexLocker locker(&frozenFrameMutex);
+    return frozenFrame;
+}
+
+void CaptureBox::releaseFrozenFrame()
+{
+    QMutexLocker locker(&frozenFrameMutex);
+    frozenFrame = QImage();
+}
+
 void CaptureBox::hotkeyPressed(int id)
 {
     if(id == MouseHook::LEFT_MOUSE_DOWN)
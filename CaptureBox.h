@@ -22,6 +22,7 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QtGui>
 #include <QDialog>
+#include <QMutex>
 #include <QTimer>
 
 
@@ -49,6 +50,10 @@ public:
     QColor getBorderColor() const { return borderColor; }
     void setBorderColor(const QColor &value) { borderColor = value; }
 
+    void setUseFrozenFrame(bool value) { useFrozenFrame = value; }
+    QImage getFrozenFrame();
+    void releaseFrozenFrame();
+
 public slots:
     void turnOnBackground() { useBackgroundColor = true; repaint(); }
     void turnOffBackground() { useBackgroundColor = false; repaint(); }
@@ -98,6 +103,12 @@ private:
     QPoint dragPosition;
 
     QTimer moveTimer;
+
+    // Screen contents grabbed when capture mode started, used instead of
+    // fresh screenshots when useFrozenFrame is set
+    bool useFrozenFrame;
+    QImage frozenFrame;
+    QMutex frozenFrameMutex;
 };
 
 #endif // CAPTURE_BOX_H
@@ -26,6 +26,7 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 #include <QScreen>
 #include <QTextStream>
 #include "CommandLine.h"
+#include "DebugImageWriter.h"
 #include "UtilsImg.h"
 #include "UtilsCommon.h"
 #include "UtilsLang.h"
@@ -35,6 +36,7 @@ CommandLine::CommandLine()
     : debug(false),
       debugAppendTimestamp(false),
       keepLineBreaks(false),
+      parallelLines(false),
       outputFilePath(""),
       outputFormat("${capture}${linebreak}")
 {
@@ -97,6 +99,12 @@ Options:
                                      Range: [0.71, 5.0]. Default is 3.5.
   --tess-config-file <file>          (Advanced) Path to Tesseract configuration
                                      file.
+  --parallel-lines                   Split multi-line images into text lines
+                                     and OCR the lines in parallel.
+  --engine-mode <mode>               OCR engine mode: "lstm", "legacy",
+                                     "combined" or "default".
+  --model-tier <tier>                Use the models in tessdata_<tier> (for
+                                     example "fast" or "best") when present.
   --portable                         Store .ini settings file in same directory
                                      as the .exe file.
 */
@@ -220,6 +228,21 @@ bool CommandLine::process(QCoreApplication &app)
                                             "file");
     parser.addOption(tessConfigFileOption);
 
+    QCommandLineOption parallelLinesOption("parallel-lines",
+                                           "Split multi-line images into text lines and OCR the lines in parallel.");
+    parser.addOption(parallelLinesOption);
+
+    QCommandLineOption engineModeOption("engine-mode",
+                                        "OCR engine mode: \"lstm\", \"legacy\", \"combined\" or \"default\". Default is \"default\".",
+                                        "mode", "default");
+    parser.addOption(engineModeOption);
+
+    QCommandLineOption modelTierOption("model-tier",
+                                       "Use the models in the tessdata_<tier> directory (for example \"fast\" or \"best\") "
+                                       "instead of tessdata when present.",
+                                       "tier");
+    parser.addOption(modelTierOption);
+
 #ifndef CLI_BUILD
     QCommandLineOption portableOption(QStringList() << "portable",
                                       "Store .ini settings file in same directory as the .exe file.");
@@ -280,12 +303,21 @@ bool CommandLine::process(QCoreApplication &app)
     imagePreprocessor.setVerticalOrientation(verticalOrientation);
     imagePreprocessor.setRemoveFurigana(UtilsLang::languageSupportsFurigana(lang));
 
-    ocrEngine->setVerticalOrientation(verticalOrientation);
-    ocrEngine->setWhitelist(whitelist);
-    ocrEngine->setBlacklist(blacklist);
-    ocrEngine->setConfigFile(tessConfigFile);
+    ocrOptions.verticalOrientation = verticalOrientation;
+    ocrOptions.whitelist = whitelist;
+    ocrOptions.blacklist = blacklist;
+    ocrOptions.configFile = tessConfigFile;
+
+    bool engineModeValid = false;
+    tesseract::OcrEngineMode engineMode = OcrEngine::engineModeFromString(parser.value(engineModeOption), &engineModeValid);
+
+    if(!engineModeValid)
+    {
+        errStream << "Error, invalid engine mode. Use \"lstm\", \"legacy\", \"combined\" or \"default\"." << endl;
+        return false;
+    }
 
-    if(!ocrEngine->setLang(lang))
+    if(!ocrEngine->setLang(lang, engineMode, parser.value(modelTierOption)))
     {
         errStream << "Error, specified OCR language not found." << endl;
         showInstalledLanguages();
@@ -303,6 +335,7 @@ bool CommandLine::process(QCoreApplication &app)
     copyToClipboard = parser.isSet(clipboardOption);
     preprocessTrim = parser.isSet(preprocessTrimOption);
     preprocessDeskew = parser.isSet(preprocessDeskewOption);
+    parallelLines = parser.isSet(parallelLinesOption);
     bool scaleFactorOk = true;
     double scaleFactor = parser.value(scaleFactorOption).toDouble(&scaleFactorOk);
 
@@ -360,6 +393,11 @@ bool CommandLine::process(QCoreApplication &app)
         outputFile.close();
     }
 
+    if(debug)
+    {
+        DebugImageWriter::getInstance().flush();
+    }
+
     if(copyToClipboard)
     {
         QGuiApplication::clipboard()->setText(allOcrText);
@@ -393,7 +431,7 @@ QString CommandLine::ocrScreenRect(QRect rect)
 
     if(debug)
     {
-        img.save(getDebugImagePath("debug_capture.png"));
+        DebugImageWriter::getInstance().write(img, getDebugImagePath("debug_capture.png"));
     }
 
     PIX *inPixs = imagePreprocessor.convertImageToPix(img);
@@ -408,9 +446,7 @@ QString CommandLine::ocrScreenRect(QRect rect)
 
     if(debug)
     {
-        QString savePath = getDebugImagePath("debug_enhanced.png");
-        QByteArray byteArray = savePath.toLocal8Bit();
-        pixWriteImpliedFormat(byteArray.constData(), pixs, 0, 0);
+        DebugImageWriter::getInstance().write(pixs, getDebugImagePath("debug_enhanced.png"));
     }
 
     bool singleLine = false;
@@ -420,7 +456,16 @@ QString CommandLine::ocrScreenRect(QRect rect)
         singleLine = (imagePreprocessor.getJapNumTextLines() == 1);
     }
 
-    QString ocrText = ocrEngine->performOcr(pixs, singleLine);
+    QString ocrText;
+
+    if(parallelLines)
+    {
+        ocrText = ocrEnginePool.performOcr(ocrEngine, pixs, imagePreprocessor.getScaleFactor(), singleLine, ocrOptions);
+    }
+    else
+    {
+        ocrText = ocrEngine->performOcr(pixs, singleLine, ocrOptions);
+    }
 
     pixDestroy(&pixs);
 
@@ -539,9 +584,7 @@ QString CommandLine::ocrImageFile(QString img)
 
     if(debug)
     {
-        QString savePath = getDebugImagePath("debug_enhanced.png");
-        QByteArray byteArray = savePath.toLocal8Bit();
-        pixWriteImpliedFormat(byteArray.constData(), pixs, 0, 0);
+        DebugImageWriter::getInstance().write(pixs, getDebugImagePath("debug_enhanced.png"));
     }
 
     bool singleLine = false;
@@ -551,7 +594,17 @@ QString CommandLine::ocrImageFile(QString img)
         singleLine = (imagePreprocessor.getJapNumTextLines() == 1);
     }
 
-    QString ocrText = ocrEngine->performOcr(pixs, singleLine);
+    QString ocrText;
+
+    if(parallelLines)
+    {
+        ocrText = ocrEnginePool.performOcr(ocrEngine, pixs, imagePreprocessor.getScaleFactor(), singleLine, ocrOptions);
+    }
+    else
+    {
+        ocrText = ocrEngine->performOcr(pixs, singleLine, ocrOptions);
+    }
+
     pixDestroy(&pixs);
 
     if(ocrText.size() == 0)
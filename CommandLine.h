@@ -25,6 +25,7 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 #include <QString>
 #include <QDateTime>
 #include "OcrEngine.h"
+#include "OcrEnginePool.h"
 #include "PreProcess.h"
 
 class CommandLine
@@ -58,12 +59,15 @@ private:
     QString outputFormat;
     PreProcess imagePreprocessor;
     OcrEngine *ocrEngine;
+    OcrEnginePool ocrEnginePool;
+    OcrOptions ocrOptions;
     bool debug;
     bool debugAppendTimestamp;
     bool keepLineBreaks;
     bool copyToClipboard;
     bool preprocessTrim;
     bool preprocessDeskew;
+    bool parallelLines;
     QDateTime captureTimestamp;
     QFile outputFile;
     QString currentImageFile;
@@ -0,0 +1,256 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ConnComp.h"
+
+ConnComp::ConnComp(PIX *pixs, int connectivity)
+    : valid(false),
+      width(0),
+      height(0),
+      xres(0),
+      yres(0)
+{
+    if(pixs == nullptr || pixGetDepth(pixs) != 1 || (connectivity != 4 && connectivity != 8))
+    {
+        return;
+    }
+
+    width = pixGetWidth(pixs);
+    height = pixGetHeight(pixs);
+    xres = pixGetXRes(pixs);
+    yres = pixGetYRes(pixs);
+
+    const int wpl = pixGetWpl(pixs);
+    const l_uint32 *data = pixGetData(pixs);
+
+    // With 8-connectivity, runs that only touch diagonally are connected
+    const int reach = (connectivity == 8) ? 1 : 0;
+
+    // Mask of the valid pixels in the last word of a row
+    const int lastWord = (width - 1) >> 5;
+    const l_uint32 lastWordMask = 0xffffffff << (31 - ((width - 1) & 31));
+
+    int prevRowBegin = 0;
+    int prevRowEnd = 0;
+
+    for(int y = 0; y < height; y++)
+    {
+        const l_uint32 *line = data + y * wpl;
+        int rowBegin = runs.size();
+        bool inRun = false;
+        int runStart = 0;
+
+        for(int i = 0; i <= lastWord; i++)
+        {
+            l_uint32 word = line[i];
+
+            if(i == lastWord)
+            {
+                word &= lastWordMask;
+            }
+
+            // Skip words that do not change the run state
+            if((!inRun && word == 0) || (inRun && word == 0xffffffff))
+            {
+                continue;
+            }
+
+            for(int bit = 0; bit < 32; bit++)
+            {
+                bool isSet = (word >> (31 - bit)) & 1;
+                int x = (i << 5) + bit;
+
+                if(isSet && !inRun)
+                {
+                    inRun = true;
+                    runStart = x;
+                }
+                else if(!isSet && inRun)
+                {
+                    inRun = false;
+                    addRun(y, runStart, x - 1);
+                }
+            }
+        }
+
+        if(inRun)
+        {
+            addRun(y, runStart, width - 1);
+        }
+
+        int rowEnd = runs.size();
+
+        // Merge with the overlapping runs of the previous row. Both rows are sorted by x.
+        int prev = prevRowBegin;
+
+        for(int cur = rowBegin; cur < rowEnd; cur++)
+        {
+            while(prev < prevRowEnd && runs[prev].end + reach < runs[cur].start)
+            {
+                prev++;
+            }
+
+            for(int p = prev; p < prevRowEnd && runs[p].start <= runs[cur].end + reach; p++)
+            {
+                unite(cur, p);
+            }
+        }
+
+        prevRowBegin = rowBegin;
+        prevRowEnd = rowEnd;
+    }
+
+    // Collect the components
+    QVector<int> componentOfRoot(runs.size(), -1);
+    runComponents.resize(runs.size());
+
+    for(int r = 0; r < runs.size(); r++)
+    {
+        int root = findRoot(r);
+        int index = componentOfRoot[root];
+        const Run &run = runs[r];
+        bool onBorder = (run.start == 0 || run.end == width - 1 || run.y == 0 || run.y == height - 1);
+
+        if(index < 0)
+        {
+            index = components.size();
+            componentOfRoot[root] = index;
+            components.append({ run.start, run.y, run.end - run.start + 1, 1, onBorder });
+        }
+        else
+        {
+            Component &comp = components[index];
+            int right = qMax(comp.x + comp.w - 1, run.end);
+            int bottom = qMax(comp.y + comp.h - 1, run.y);
+            comp.x = qMin(comp.x, run.start);
+            comp.y = qMin(comp.y, run.y);
+            comp.w = right - comp.x + 1;
+            comp.h = bottom - comp.y + 1;
+            comp.touchesBorder |= onBorder;
+        }
+
+        runComponents[r] = index;
+    }
+
+    parents.clear();
+    valid = true;
+}
+
+void ConnComp::addRun(int y, int start, int end)
+{
+    runs.append({ y, start, end });
+    parents.append(parents.size());
+}
+
+int ConnComp::findRoot(int run)
+{
+    while(parents[run] != run)
+    {
+        // Path halving
+        parents[run] = parents[parents[run]];
+        run = parents[run];
+    }
+
+    return run;
+}
+
+void ConnComp::unite(int run1, int run2)
+{
+    int root1 = findRoot(run1);
+    int root2 = findRoot(run2);
+
+    // Keep the earlier run as root so that components are numbered in raster order
+    if(root1 < root2)
+    {
+        parents[root2] = root1;
+    }
+    else if(root2 < root1)
+    {
+        parents[root1] = root2;
+    }
+}
+
+// Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+PIX *ConnComp::render(const QVector<bool> &keep) const
+{
+    if(!valid || keep.size() != components.size())
+    {
+        return nullptr;
+    }
+
+    PIX *pixd = pixCreate(width, height, 1);
+
+    if(pixd == nullptr)
+    {
+        return nullptr;
+    }
+
+    pixSetResolution(pixd, xres, yres);
+
+    const int wpl = pixGetWpl(pixd);
+    l_uint32 *data = pixGetData(pixd);
+
+    for(int r = 0; r < runs.size(); r++)
+    {
+        if(!keep[runComponents[r]])
+        {
+            continue;
+        }
+
+        const Run &run = runs[r];
+        l_uint32 *line = data + run.y * wpl;
+        int startWord = run.start >> 5;
+        int endWord = run.end >> 5;
+        l_uint32 startMask = 0xffffffff >> (run.start & 31);
+        l_uint32 endMask = 0xffffffff << (31 - (run.end & 31));
+
+        if(startWord == endWord)
+        {
+            line[startWord] |= startMask & endMask;
+        }
+        else
+        {
+            line[startWord] |= startMask;
+
+            for(int i = startWord + 1; i < endWord; i++)
+            {
+                line[i] = 0xffffffff;
+            }
+
+            line[endWord] |= endMask;
+        }
+    }
+
+    return pixd;
+}
+
+// Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+PIX *ConnComp::select(bool removeBorder, int minBlobSize) const
+{
+    QVector<bool> keep(components.size());
+
+    for(int i = 0; i < components.size(); i++)
+    {
+        const Component &comp = components[i];
+        keep[i] = (!removeBorder || !comp.touchesBorder)
+                && (comp.w > minBlobSize || comp.h > minBlobSize);
+    }
+
+    return render(keep);
+}
@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONN_COMP_H
+#define CONN_COMP_H
+
+#include <QVector>
+
+#include "allheaders.h"
+
+// Connected components of a 1 bpp image, found in a single sweep over the packed rows.
+// Each row is split into runs of foreground pixels, runs that touch a run of the previous
+// row are merged with union-find, and the bounding box and border contact of every
+// component are collected along the way. A filtered image can then be rendered
+// from the runs without labeling the image again.
+class ConnComp
+{
+public:
+    struct Component
+    {
+        int x;
+        int y;
+        int w;
+        int h;
+
+        // Does the component touch an edge of the image
+        bool touchesBorder;
+    };
+
+    // pixs must be 1 bpp. connectivity is 4 or 8. pixs is not referenced after construction.
+    ConnComp(PIX *pixs, int connectivity=8);
+
+    bool isValid() const { return valid; }
+    const QVector<Component> &getComponents() const { return components; }
+
+    // Render the components for which keep is true (keep is indexed like getComponents()).
+    // Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+    PIX *render(const QVector<bool> &keep) const;
+
+    // Keep components that do not touch the border (if removeBorder is set) and whose
+    // width or height is greater than minBlobSize, like pixSelectBySize() with
+    // L_SELECT_IF_EITHER and L_SELECT_IF_GT.
+    // Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+    PIX *select(bool removeBorder, int minBlobSize) const;
+
+private:
+    struct Run
+    {
+        int y;
+        int start;
+        int end; // Inclusive
+    };
+
+    void addRun(int y, int start, int end);
+    int findRoot(int run);
+    void unite(int run1, int run2);
+
+    bool valid;
+    int width;
+    int height;
+    int xres;
+    int yres;
+    QVector<Run> runs;
+    QVector<int> parents;       // Union-find parent of each run, only used while labeling
+    QVector<int> runComponents; // Component index of each run
+    QVector<Component> components;
+};
+
+#endif // CONN_COMP_H
@@ -0,0 +1,197 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDebug>
+#include <QImageWriter>
+#include "DebugImageWriter.h"
+
+DebugImageWriter::DebugImageWriter()
+    : queuedBytes(0),
+      memoryBudget(64 * 1024 * 1024),
+      droppedCount(0),
+      droppedBytes(0),
+      writing(false),
+      stopping(false)
+{
+
+}
+
+DebugImageWriter::~DebugImageWriter()
+{
+    mutex.lock();
+    stopping = true;
+    workAvailable.wakeAll();
+    mutex.unlock();
+
+    // The thread writes the remaining queue before it exits
+    wait();
+}
+
+void DebugImageWriter::write(const QImage &image, const QString &path)
+{
+    if(image.isNull())
+    {
+        return;
+    }
+
+    // QImage is implicitly shared, so this does not copy the pixels
+    Job job;
+    job.path = path;
+    job.image = image;
+    job.pixs = nullptr;
+    job.bytes = (qint64)image.bytesPerLine() * image.height();
+    enqueue(job);
+}
+
+// pixs is copied, the caller keeps ownership.
+void DebugImageWriter::write(PIX *pixs, const QString &path)
+{
+    if(pixs == nullptr)
+    {
+        return;
+    }
+
+    // A copy rather than a clone, leptonica reference counts are not thread safe
+    Job job;
+    job.path = path;
+    job.pixs = pixCopy(nullptr, pixs);
+    job.bytes = (qint64)pixGetWpl(pixs) * 4 * pixGetHeight(pixs);
+
+    if(job.pixs == nullptr)
+    {
+        return;
+    }
+
+    enqueue(job);
+}
+
+void DebugImageWriter::enqueue(const Job &job)
+{
+    QMutexLocker locker(&mutex);
+
+    // Always accept an image when nothing is queued, so that a single large image is still written
+    if(!queue.isEmpty() && queuedBytes + job.bytes > memoryBudget)
+    {
+        droppedCount++;
+        droppedBytes += job.bytes;
+        qWarning() << "Debug image dropped, writer queue is full:" << job.path
+                   << "(" << droppedCount << "images," << droppedBytes << "bytes dropped so far)";
+
+        Job dropped = job;
+        pixDestroy(&dropped.pixs);
+        return;
+    }
+
+    queue.enqueue(job);
+    queuedBytes += job.bytes;
+
+    if(!isRunning())
+    {
+        start(QThread::LowPriority);
+    }
+
+    workAvailable.wakeOne();
+}
+
+void DebugImageWriter::flush()
+{
+    QMutexLocker locker(&mutex);
+
+    while(!queue.isEmpty() || writing)
+    {
+        workDone.wait(&mutex);
+    }
+}
+
+qint64 DebugImageWriter::getMemoryBudget()
+{
+    QMutexLocker locker(&mutex);
+    return memoryBudget;
+}
+
+void DebugImageWriter::setMemoryBudget(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    memoryBudget = bytes;
+}
+
+int DebugImageWriter::getDroppedCount()
+{
+    QMutexLocker locker(&mutex);
+    return droppedCount;
+}
+
+void DebugImageWriter::run()
+{
+    mutex.lock();
+
+    while(true)
+    {
+        while(queue.isEmpty() && !stopping)
+        {
+            workAvailable.wait(&mutex);
+        }
+
+        if(queue.isEmpty())
+        {
+            break;
+        }
+
+        Job job = queue.dequeue();
+        writing = true;
+        mutex.unlock();
+
+        writeJob(job);
+
+        mutex.lock();
+        queuedBytes -= job.bytes;
+        writing = false;
+        workDone.wakeAll();
+    }
+
+    mutex.unlock();
+}
+
+void DebugImageWriter::writeJob(Job &job)
+{
+    if(job.pixs != nullptr)
+    {
+        // Only used by the PNG writer
+        pixSetZlibCompression(job.pixs, pngCompressionLevel);
+
+        QByteArray byteArray = job.path.toLocal8Bit();
+        pixWriteImpliedFormat(byteArray.constData(), job.pixs, 0, 0);
+        pixDestroy(&job.pixs);
+    }
+    else
+    {
+        QImageWriter writer(job.path);
+
+        // For PNG, quality maps to the zlib level as (100 - quality) * 9 / 91
+        if(job.path.endsWith(".png", Qt::CaseInsensitive))
+        {
+            writer.setQuality(100 - (pngCompressionLevel * 91 + 8) / 9);
+        }
+
+        if(!writer.write(job.image))
+        {
+            qWarning() << "Failed to write debug image:" << job.path << writer.errorString();
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DEBUG_IMAGE_WRITER_H
+#define DEBUG_IMAGE_WRITER_H
+
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "allheaders.h"
+
+// Writes debug images on a background thread so that encoding and disk I/O stay off the
+// capture path. Images wait in memory until they are written. If the queued images would
+// exceed the memory budget, new images are dropped and counted instead of blocking.
+class DebugImageWriter : public QThread
+{
+public:
+    static DebugImageWriter &getInstance()
+    {
+        static DebugImageWriter instance;
+        return instance;
+    }
+
+    void write(const QImage &image, const QString &path);
+    void write(PIX *pixs, const QString &path);
+
+    // Wait until all queued images are written
+    void flush();
+
+    qint64 getMemoryBudget();
+    void setMemoryBudget(qint64 bytes);
+
+    int getDroppedCount();
+
+protected:
+    void run();
+
+private:
+    DebugImageWriter();
+    ~DebugImageWriter();
+
+    struct Job
+    {
+        QString path;
+        QImage image;
+        PIX *pixs;
+        qint64 bytes;
+    };
+
+    void enqueue(const Job &job);
+    void writeJob(Job &job);
+
+    // zlib level used for PNG files: fastest compression
+    static const int pngCompressionLevel = 1;
+
+    QMutex mutex;
+    QWaitCondition workAvailable;
+    QWaitCondition workDone;
+    QQueue<Job> queue;
+    qint64 queuedBytes;
+    qint64 memoryBudget;
+    int droppedCount;
+    qint64 droppedBytes;
+    bool writing;
+    bool stopping;
+};
+
+#endif // DEBUG_IMAGE_WRITER_H
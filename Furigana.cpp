@@ -336,6 +336,89 @@ bool Furigana::eraseFuriganaHorizontal(PIX *pixs, float scaleFactor, int *numTex
     return true;
 }
 
+// Find the text lines (columns for vertical text) in the provided binary PIX using
+// the same span analysis as the furigana removal. Each returned rectangle spans the
+// full width (height for vertical text) of the PIX and extends halfway into the gaps
+// between neighboring lines so that no foreground pixels are lost.
+// Lines are returned in reading order: top to bottom, or right to left for vertical text.
+QList<QRect> Furigana::findTextLines(PIX *pixs, float scaleFactor, bool vertical)
+{
+    int minFgPixPerLine = qMax((int)(FURIGANA_MIN_FG_PIX_PER_LINE * scaleFactor), 1);
+    int minSpanWidth = (int)(FURIGANA_MIN_WIDTH * scaleFactor);
+    int length = vertical ? pixs->w : pixs->h;
+    QList<FuriganaSpan> spanList;
+    QList<QRect> lineList;
+
+    NUMA *fgCounts = vertical ? pixCountPixelsByColumn(pixs) : pixCountPixelsByRow(pixs, nullptr);
+
+    if (fgCounts == nullptr)
+    {
+        return lineList;
+    }
+
+    FuriganaSpan span(NO_VALUE, NO_VALUE);
+
+    for (int i = 0; i <= length; i++)
+    {
+        int numFgPixelsOnLine = 0;
+
+        if (i < length)
+        {
+            numaGetIValue(fgCounts, i, &numFgPixelsOnLine);
+        }
+
+        if (numFgPixelsOnLine >= minFgPixPerLine)
+        {
+            if (span.start == NO_VALUE)
+            {
+                span.start = i;
+            }
+        }
+        else if (span.start != NO_VALUE)
+        {
+            span.end = i - 1;
+
+            if (span.getLength() >= minSpanWidth)
+            {
+                spanList.append(span);
+            }
+
+            span.start = NO_VALUE;
+            span.end = NO_VALUE;
+        }
+    }
+
+    numaDestroy(&fgCounts);
+
+    for (int spanIdx = 0; spanIdx < spanList.size(); spanIdx++)
+    {
+        int start = 0;
+        int end = length - 1;
+
+        if (spanIdx > 0)
+        {
+            start = (spanList[spanIdx - 1].end + spanList[spanIdx].start + 1) / 2;
+        }
+
+        if (spanIdx < spanList.size() - 1)
+        {
+            end = (spanList[spanIdx].end + spanList[spanIdx + 1].start - 1) / 2;
+        }
+
+        if (vertical)
+        {
+            // Right-to-left column order
+            lineList.prepend(QRect(start, 0, end - start + 1, pixs->h));
+        }
+        else
+        {
+            lineList.append(QRect(0, start, pixs->w, end - start + 1));
+        }
+    }
+
+    return lineList;
+}
+
 // Clear/erase a left-to-right section of the provided binary PIX.
 bool Furigana::eraseAreaLeftToRight(PIX *pixs, int x, int width)
 {
@@ -20,6 +20,8 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef FURIGANA_H
 #define FURIGANA_H
 
+#include <QList>
+#include <QRect>
 #include "allheaders.h"
 
 class Furigana
@@ -28,6 +30,7 @@ public:
 
     static bool eraseFuriganaVertical(PIX *pixs, float scaleFactor, int *numTextLines);
     static bool eraseFuriganaHorizontal(PIX *pixs, float scaleFactor, int *numTextLines);
+    static QList<QRect> findTextLines(PIX *pixs, float scaleFactor, bool vertical);
 
 private:
     // Span of lines that contain foreground text. Used during furigana removal.
@@ -27,6 +27,7 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "MainWindow.h"
 #include "CaptureBox.h"
+#include "DebugImageWriter.h"
 #include "OcrEngine.h"
 #include "PreProcess.h"
 #include "PostProcess.h"
@@ -41,7 +42,10 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 
 
 MainWindow::MainWindow(bool portable)
-    : pendingPreviewRequest(false)
+    : pendingPreviewRequest(false),
+      captureAttachedToPreview(false),
+      previewFastPass(false),
+      hasPendingHotkeyCapture(false)
 {
     if(portable)
     {
@@ -52,7 +56,10 @@ MainWindow::MainWindow(bool portable)
 
     createTrayMenu();
 
+    // The language is loaded in the background by setOcrLang(), the first
+    // capture waits for it if it is not done yet
     ocrEngine = new OcrEngine();
+    previewEngine = new OcrEngine();
 
     if(OcrEngine::isLangInstalled(Settings::getOcrLang()))
     {
@@ -96,10 +103,13 @@ MainWindow::MainWindow(bool portable)
     infoBox.setTextFont(Settings::getPreviewTextFont());
 
     connect(&watcherPreview, &QFutureWatcher<QString>::finished, this, &MainWindow::ocrPreviewComplete);
+    previewEnginePool.setMaxEngines(Settings::getPreviewMaxEngines());
 
     watcherCapture.setPendingResultsLimit(1);
     connect(&watcherCapture, &QFutureWatcher<QString>::finished, this, &MainWindow::ocrCaptureComplete);
 
+    connect(&watcherHotkeyCapture, &QFutureWatcher<HotkeyCaptureResult>::finished, this, &MainWindow::hotkeyCaptureComplete);
+
     popupDialog.resize(Settings::getOutputPopupWindowSize());
     popupDialog.setTopmost(Settings::getOutputPopupTopmost());
 
@@ -108,6 +118,20 @@ MainWindow::MainWindow(bool portable)
     connect(&settingsDialog, &SettingsDialog::accepted, this, &MainWindow::settingsAccepted);
 
     connect(&translate, &Translate::translationComplete, this, &MainWindow::translationComplete);
+    translate.setCacheCapacity(Settings::getTranslateCacheSize());
+
+    TranslateBackend *translateBackend = TranslateBackend::create(Settings::getTranslateBackend(),
+                                                                  Settings::getTranslateEndpoint());
+
+    if(translateBackend != nullptr)
+    {
+        translate.setBackend(translateBackend);
+    }
+
+    if(Settings::getTranslateCachePersist())
+    {
+        translate.setCacheFile(QFileInfo(QSettings().fileName()).absolutePath() + "/translation_cache.dat");
+    }
 
     connect(&KeyboardHook::getInstance(), &KeyboardHook::keyPressed, this, &MainWindow::hotkeyPressed);
     registerHotkeys();
@@ -125,6 +149,18 @@ MainWindow::MainWindow(bool portable)
 
 MainWindow::~MainWindow()
 {
+    // Previews run in the global thread pool and use ocrEngine or previewEngine, so stop
+    // the preview in progress before the engines are deleted. The preview may be blocked
+    // on this thread (see turnOffBackground), so keep processing events while waiting.
+    disconnect(&watcherPreview, nullptr, this, nullptr);
+    previewCancel.store(1);
+
+    while(watcherPreview.isRunning())
+    {
+        QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+        QThread::msleep(5);
+    }
+
     KeyboardHook::getInstance().endThread();
     MouseHook::getInstance().endThread();
     delete actionSaveToClipboard;
@@ -133,7 +169,10 @@ MainWindow::~MainWindow()
     delete actionGroupTextOrientation;
     delete menuTrayIcon;
     delete trayIcon;
+    captureThreadPool.waitForDone();
+    DebugImageWriter::getInstance().flush();
     delete ocrEngine;
+    delete previewEngine;
 }
 
 void MainWindow::captureBoxCaptured()
@@ -143,13 +182,22 @@ void MainWindow::captureBoxCaptured()
 
 void MainWindow::startCaptureBox()
 {
+    previewTileCache.clear();
+    previewChangeDetector.clear();
+    captureAttachedToPreview = false;
+
+    // Start capture mode before showing the preview box so that a frozen frame does not contain it
+    captureBox.setUseFrozenFrame(Settings::getCaptureBoxFrozenFrame());
+    captureBox.startCaptureMode();
+
+    prewarmTranslation();
+
     if(Settings::getPreviewEnabled())
     {
         previewBox.move(QPoint(0, 0));
         previewBox.show();
         previewBox.raise();
     }
-    captureBox.startCaptureMode();
 }
 
 void MainWindow::endCaptureBox()
@@ -161,15 +209,34 @@ void MainWindow::endCaptureBox()
     QRect captureRect = captureBox.getCaptureRect();
     if(captureRect.width() <= minOcrWidth || captureRect.height() <= minOcrHeight)
     {
+        captureBox.releaseFrozenFrame();
+        return;
+    }
+
+    // If a preview of this exact rect is being OCR'd, wait for it to complete, then capture.
+    // The capture uses the result of the preview if the screen still matches it exactly.
+    if(Settings::getPreviewEnabled() && Settings::getPreviewReuseResult() && !isDebugImageSaveEnabled()
+            && watcherPreview.isRunning() && !pendingPreviewRequest && !previewFastPass
+            && captureRect == previewRect && getOcrSettingsFingerprint(false) == previewFingerprint)
+    {
+        captureAttachedToPreview = true;
         return;
     }
 
-    QFuture<QString> futureCapture = QtConcurrent::run(this, &MainWindow::ocrCaptureBoxArea);
+    // The preview is out of date, stop it so that it does not compete with the capture
+    if(watcherPreview.isRunning())
+    {
+        previewCancel.store(1);
+    }
+
+    QFuture<QString> futureCapture = QtConcurrent::run(&captureThreadPool, this, &MainWindow::ocrCaptureBoxArea, false);
     watcherCapture.setFuture(futureCapture);
 }
 
 void MainWindow::ocrCaptureComplete()
 {
+    captureBox.releaseFrozenFrame();
+
     QString ocrText = watcherCapture.result();
     ocrText = postProcess(ocrText);
     outputOcrText(ocrText);
@@ -206,46 +273,118 @@ bool MainWindow::isOrientationVertical()
     }
 }
 
-QString MainWindow::ocrCaptureBoxArea()
+// OCR the capture box area for a preview or the final capture. If fastPass is set, this is the
+// first pass of a progressive preview, which uses a lower scale factor and skips deskewing.
+QString MainWindow::ocrCaptureBoxArea(bool fastPass)
 {
     bool previewEnabled = Settings::getPreviewEnabled();
     previewEnabled &= !previewBox.isHidden();
 
-    if(previewEnabled)
+    PreProcessOptions options;
+    options.scaleFactor = Settings::getOcrScaleFactor();
+    options.verticalText = isOrientationVertical();
+    options.removeFurigana = UtilsLang::languageSupportsFurigana(Settings::getOcrLang());
+    options.deskew = Settings::getOcrDeskew() && !fastPass;
+    options.trim = Settings::getOcrTrim();
+
+    if(fastPass)
     {
-        QMetaObject::invokeMethod(&captureBox, "turnOffBackground", Qt::BlockingQueuedConnection);
+        options.scaleFactor = qMin(options.scaleFactor, (float)Settings::getPreviewFastScaleFactor());
     }
 
     QRect captureRect = captureBox.getCaptureRect();
-    QImage image = UtilsImg::takeScreenshot(captureRect);
+    PreProcessResult preProcessResult;
+    PIX *pixs = nullptr;
+    QImage image;
 
-    if(previewEnabled)
+    // In frozen frame mode, crop from the frame instead of taking a screenshot.
+    // The capture box is not part of the frame so it does not need to be hidden.
+    QImage frozenFrame = captureBox.getFrozenFrame();
+    bool hideCaptureBox = previewEnabled && frozenFrame.isNull();
+
+    // Screen contents and OCR settings, used to skip the OCR of a final capture when it
+    // matches the last final capture or the last preview
+    QString settingsFingerprint = getOcrSettingsFingerprint(previewEnabled);
+    ScreenChangeDetector::Signature signature;
+
+    // The fast pass does not use the tile cache, which is kept for the full quality scale factor
+    if(previewEnabled && Settings::getPreviewIncremental() && !fastPass)
     {
-        QMetaObject::invokeMethod(&captureBox, "turnOnBackground", Qt::BlockingQueuedConnection);
+        preProcessResult = preProcessIncrementalPreview(captureRect, frozenFrame, options, &signature);
+        pixs = preProcessResult.pixs;
 
         if(pendingPreviewRequest)
         {
+            pixDestroy(&pixs);
             return previewBox.getText();
         }
     }
-
-    if(image.isNull())
+    else
     {
-        return "<Error>";
-    }
+        if(hideCaptureBox)
+        {
+            QMetaObject::invokeMethod(&captureBox, "turnOffBackground", Qt::BlockingQueuedConnection);
+        }
 
-    if(!captureBox.isVisible() && Settings::getDebugSaveCaptureImage())
-    {
-        image.save(getDebugImagePath("debug_capture.png"));
-    }
+        image = UtilsImg::takeScreenshot(captureRect, frozenFrame);
 
-    preProcess.setVerticalOrientation(isOrientationVertical());
-    preProcess.setRemoveFurigana(UtilsLang::languageSupportsFurigana(Settings::getOcrLang()));
-    preProcess.setScaleFactor(Settings::getOcrScaleFactor());
+        if(hideCaptureBox)
+        {
+            QMetaObject::invokeMethod(&captureBox, "turnOnBackground", Qt::BlockingQueuedConnection);
+        }
 
-    PIX *inPixs = preProcess.convertImageToPix(image);
-    PIX *pixs = preProcess.processImage(inPixs, Settings::getOcrDeskew(), Settings::getOcrTrim());
-    pixDestroy(&inPixs);
+        if(previewEnabled && pendingPreviewRequest)
+        {
+            return previewBox.getText();
+        }
+
+        if(image.isNull())
+        {
+            return "<Error>";
+        }
+
+        signature = ScreenChangeDetector::computeSignature(image);
+
+        // Reused results would skip the debug images
+        if(!previewEnabled && !isDebugImageSaveEnabled())
+        {
+            QString lastResult;
+
+            if(Settings::getOcrSkipUnchanged()
+                    && screenChangeDetector.getLastResult(captureRect, settingsFingerprint, signature, &lastResult))
+            {
+                return lastResult;
+            }
+
+            if(Settings::getPreviewReuseResult()
+                    && previewChangeDetector.getLastResult(captureRect, settingsFingerprint, signature, &lastResult))
+            {
+                if(Settings::getOcrSkipUnchanged())
+                {
+                    screenChangeDetector.setLastResult(captureRect, settingsFingerprint, signature, lastResult);
+                }
+
+                return lastResult;
+            }
+        }
+
+        if(!captureBox.isVisible() && Settings::getDebugSaveCaptureImage())
+        {
+            DebugImageWriter::getInstance().write(image, getDebugImagePath("debug_capture.png"));
+        }
+
+        PreProcess preProcess(options);
+        PIX *inPixs = preProcess.convertImageToPix(image);
+
+        if(inPixs == nullptr)
+        {
+            return "<Error>";
+        }
+
+        preProcessResult = PreProcess::processImage(inPixs, options);
+        pixs = preProcessResult.pixs;
+        pixDestroy(&inPixs);
+    }
 
     if(pixs == nullptr)
     {
@@ -260,53 +399,167 @@ QString MainWindow::ocrCaptureBoxArea()
 
     if(!captureBox.isVisible() && Settings::getDebugSaveEnhancedImage())
     {
-        QString savePath = getDebugImagePath("debug_enhanced.png");
-        QByteArray byteArray = savePath.toLocal8Bit();
-        pixWriteImpliedFormat(byteArray.constData(), pixs, 0, 0);
+        DebugImageWriter::getInstance().write(pixs, getDebugImagePath("debug_enhanced.png"));
     }
 
-    ocrEngine->setVerticalOrientation(isOrientationVertical());
-    setOcrEngineCommon();
+    OcrEngine *engine = getOcrEngine(previewEnabled);
+
+    // The options are passed with the OCR call, the engine may be shared with other captures
+    OcrOptions ocrOptions = getOcrOptions(isOrientationVertical());
 
     bool singleLine = false;
 
     if(UtilsLang::languageSupportsFurigana(Settings::getOcrLang()))
     {
-        singleLine = (preProcess.getJapNumTextLines() == 1);
+        singleLine = (preProcessResult.numTextLines == 1);
+    }
+
+    QString ocrText;
+
+    if(Settings::getOcrParallelLines())
+    {
+        OcrEnginePool &enginePool = previewEnabled ? previewEnginePool : ocrEnginePool;
+        ocrText = enginePool.performOcr(engine, pixs, preProcessResult.scaleFactor, singleLine, ocrOptions,
+                                        previewEnabled ? &previewCancel : nullptr);
+    }
+    else
+    {
+        ocrText = engine->performOcr(pixs, singleLine, ocrOptions, previewEnabled ? &previewCancel : nullptr);
     }
 
-    QString ocrText = ocrEngine->performOcr(pixs, singleLine);
     pixDestroy(&pixs);
 
-    if(previewEnabled && pendingPreviewRequest)
+    if(previewEnabled && (pendingPreviewRequest || previewCancel.load() != 0))
     {
         return previewBox.getText();
     }
 
+    if(fastPass)
+    {
+        // Only full quality results may be reused for the final capture
+        return ocrText;
+    }
+
+    if(previewEnabled)
+    {
+        previewChangeDetector.setLastResult(captureRect, settingsFingerprint, signature, ocrText);
+    }
+    else if(Settings::getOcrSkipUnchanged())
+    {
+        screenChangeDetector.setLastResult(captureRect, settingsFingerprint, signature, ocrText);
+    }
+
     return ocrText;
 }
 
-void MainWindow::setOcrEngineCommon()
+// Pre-process the capture box area for a preview, only grabbing and pre-processing the
+// parts of the capture box that were not covered by the previous preview.
+// If frozenFrame is not null, the capture box area is cropped from it instead of the screen.
+// The signature of the grabbed screen contents is returned in signature.
+// Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+PreProcessResult MainWindow::preProcessIncrementalPreview(QRect captureRect, const QImage &frozenFrame,
+                                                          const PreProcessOptions &options,
+                                                          ScreenChangeDetector::Signature *signature)
 {
-    if(Settings::getOcrEnableWhitelist())
+    PreProcess preProcess(options);
+    PIX *pixGray = nullptr;
+    PIX *pixScaled = nullptr;
+
+    if(frozenFrame.isNull())
     {
-        ocrEngine->setWhitelist(Settings::getOcrWhitelist());
+        QMetaObject::invokeMethod(&captureBox, "turnOffBackground", Qt::BlockingQueuedConnection);
+        pixScaled = previewTileCache.capture(captureRect, preProcess, &pixGray);
+        QMetaObject::invokeMethod(&captureBox, "turnOnBackground", Qt::BlockingQueuedConnection);
     }
     else
     {
-        ocrEngine->setWhitelist("");
+        pixScaled = previewTileCache.capture(captureRect, preProcess, &pixGray, frozenFrame);
     }
 
-    if(Settings::getOcrEnableBlacklist())
+    if(pixScaled == nullptr)
     {
-        ocrEngine->setBlacklist(Settings::getOcrBlacklist());
+        return PreProcessResult();
     }
-    else
+
+    *signature = ScreenChangeDetector::computeSignature(pixGray);
+
+    PreProcessResult result = PreProcess::processScaledImage(pixGray, pixScaled, options);
+    pixDestroy(&pixGray);
+    pixDestroy(&pixScaled);
+
+    return result;
+}
+
+// Get the options of an OCR call from the settings.
+OcrOptions MainWindow::getOcrOptions(bool verticalOrientation)
+{
+    OcrOptions options;
+    options.verticalOrientation = verticalOrientation;
+    options.whitelist = Settings::getOcrEnableWhitelist() ? Settings::getOcrWhitelist() : QString("");
+    options.blacklist = Settings::getOcrEnableBlacklist() ? Settings::getOcrBlacklist() : QString("");
+    options.configFile = Settings::getOcrTesseractConfigFile();
+
+    return options;
+}
+
+// Get a string that identifies all settings that affect the OCR result of a capture box capture.
+// Two captures of the same screen contents with the same fingerprint give the same OCR result.
+QString MainWindow::getOcrSettingsFingerprint(bool preview)
+{
+    QStringList parts;
+    parts << Settings::getOcrLang()
+          << QString::number(isOrientationVertical())
+          << QString::number(Settings::getOcrScaleFactor())
+          << QString::number(Settings::getOcrDeskew())
+          << QString::number(Settings::getOcrTrim())
+          << (Settings::getOcrEnableWhitelist() ? Settings::getOcrWhitelist() : QString())
+          << (Settings::getOcrEnableBlacklist() ? Settings::getOcrBlacklist() : QString())
+          << Settings::getOcrTesseractConfigFile()
+          << QString::number(OcrEngine::engineModeFromString(getEngineModeSetting(preview)))
+          << OcrEngine::getTessdataPath(getModelTierSetting(preview));
+
+    return parts.join('\x1f');
+}
+
+// Get the engine mode to use for previews or for final captures.
+QString MainWindow::getEngineModeSetting(bool preview)
+{
+    QString mode = preview ? Settings::getPreviewEngineMode() : QString();
+    return mode.isEmpty() ? Settings::getOcrEngineMode() : mode;
+}
+
+// Get the model tier to use for previews or for final captures.
+QString MainWindow::getModelTierSetting(bool preview)
+{
+    QString tier = preview ? Settings::getPreviewModelTier() : QString();
+    return tier.isEmpty() ? Settings::getOcrModelTier() : tier;
+}
+
+// Previews use their own engine if so configured, or if they use a different engine mode or
+// model tier. Otherwise previews and captures share ocrEngine and a capture waits for the preview.
+bool MainWindow::usePreviewEngine()
+{
+    return Settings::getPreviewDedicatedEngine()
+            || OcrEngine::engineModeFromString(getEngineModeSetting(true)) != OcrEngine::engineModeFromString(getEngineModeSetting(false))
+            || OcrEngine::getTessdataPath(getModelTierSetting(true)) != OcrEngine::getTessdataPath(getModelTierSetting(false));
+}
+
+OcrEngine *MainWindow::getOcrEngine(bool preview)
+{
+    if(preview && usePreviewEngine())
     {
-        ocrEngine->setBlacklist("");
+        // Loaded on first use, nothing is loaded again unless the language or settings changed
+        loadPreviewEngine();
+        return previewEngine;
     }
 
-    ocrEngine->setConfigFile(Settings::getOcrTesseractConfigFile());
+    return ocrEngine;
+}
+
+void MainWindow::loadPreviewEngine()
+{
+    previewEngine->setLangAsync(Settings::getOcrLang(), OcrEngine::engineModeFromString(getEngineModeSetting(true)),
+                                getModelTierSetting(true));
 }
 
 QString MainWindow::getDebugImagePath(QString filename)
@@ -321,8 +574,6 @@ void MainWindow::performForwardTextLineCapture(QPoint pt)
     int idealRectLength = Settings::getForwardTextLineCaptureLength();
     int idealStartOffset = Settings::getForwardTextLineCaptureStartOffset();
 
-    captureTimestamp = QDateTime::currentDateTime();
-
     QString savedTextOrientation = Settings::getOcrTextOrientation();
 
     int totalScreenWidth = 0;
@@ -360,85 +611,7 @@ void MainWindow::performForwardTextLineCapture(QPoint pt)
         cropRect.setBottom(qMin(screenRect.height(), pt.y() + idealRectHalfWidth));
     }
 
-    QImage image = UtilsImg::takeScreenshot(cropRect);
-
-    if(image.isNull())
-    {
-        return;
-    }
-
-    if(Settings::getDebugSaveCaptureImage())
-    {
-        image.save(getDebugImagePath("debug_capture.png"));
-    }
-
-    preProcess.setVerticalOrientation(isVertical);
-    preProcess.setRemoveFurigana(UtilsLang::languageSupportsFurigana(Settings::getOcrLang()));
-    preProcess.setScaleFactor(Settings::getOcrScaleFactor());
-
-    // Get the click point relative to the cropped area
-    Point ptInCropRect(pt.x() - cropRect.left(), pt.y() - cropRect.top());
-    PIX *inPixs = preProcess.convertImageToPix(image);
-
-    PIX *pixs = preProcess.extractTextBlock(inPixs,
-                                            ptInCropRect.x,
-                                            ptInCropRect.y,
-                                            Settings::getForwardTextLineCaptureLookahead(),
-                                            Settings::getForwardTextLineCaptureLookbehind(),
-                                            Settings::getForwardTextLineCaptureSearchRadius());
-    pixDestroy(&inPixs);
-
-    if(pixs == nullptr)
-    {
-        return;
-    }
-
-    if(pixs->w <= (unsigned int)minOcrWidth || pixs->h <= (unsigned int)minOcrHeight)
-    {
-        pixDestroy(&pixs);
-        return;
-    }
-
-    if(Settings::getDebugSaveEnhancedImage())
-    {
-        QString savePath = getDebugImagePath("debug_enhanced.png");
-        QByteArray byteArray = savePath.toLocal8Bit();
-        pixWriteImpliedFormat(byteArray.constData(), pixs, 0, 0);
-    }
-
-    ocrEngine->setVerticalOrientation(isVertical);
-    setOcrEngineCommon();
-    QString ocrText = ocrEngine->performOcr(pixs, true);
-    pixDestroy(&pixs);
-
-    if(Settings::getForwardTextLineCaptureFirstWord())
-    {
-        if(ocrText.contains(' '))
-        {
-            ocrText = ocrText.left(ocrText.indexOf(' '));
-        }
-
-        if(ocrText.length() > 1)
-        {
-            ocrText = ocrText.trimmed();
-            ocrText = ocrText.replace(QRegularExpression("[\\.,!\\?;:]$"), "");
-        }
-    }
-
-    QRect boundingBox = preProcess.getBoundingRect();
-
-    QRect displayRect;
-    displayRect.setLeft(pt.x() - ptInCropRect.x + boundingBox.x() + 1);
-    displayRect.setTop(pt.y() - ptInCropRect.y + boundingBox.y() + 1);
-    displayRect.setRight(displayRect.left() + boundingBox.width());
-    displayRect.setBottom(displayRect.top() + boundingBox.height());
-
-    if(displayRect.width() > minOcrWidth && displayRect.height() > minOcrHeight)
-    {
-        autoCaptureBox.autoCapture(displayRect);
-        ocrText = postProcess(ocrText);
-        outputOcrText(ocrText);
-    }
+    requestHotkeyCapture(HotkeyCaptureRequest(FORWARD_TEXTLINE_CAPTURE, pt, cropRect, isVertical));
 }
 
 void MainWindow::performTextLineCapture(QPoint pt)
@@ -448,8 +621,6 @@ void MainWindow::performTextLineCapture(QPoint pt)
     int idealRectLength = Settings::getTextLineCaptureLength();
     int idealRectHalfLength = idealRectLength / 2;
 
-    captureTimestamp = QDateTime::currentDateTime();
-
     QString savedTextOrientation = Settings::getOcrTextOrientation();
 
     int totalScreenWidth = 0;
@@ -487,72 +658,7 @@ void MainWindow::performTextLineCapture(QPoint pt)
         cropRect.setBottom(qMin(screenRect.height(), pt.y() + idealRectHalfWidth));
     }
 
-    QImage image = UtilsImg::takeScreenshot(cropRect);
-
-    if(image.isNull())
-    {
-        return;
-    }
-
-    if(Settings::getDebugSaveCaptureImage())
-    {
-        image.save(getDebugImagePath("debug_capture.png"));
-    }
-
-    preProcess.setVerticalOrientation(isVertical);
-    preProcess.setRemoveFurigana(UtilsLang::languageSupportsFurigana(Settings::getOcrLang()));
-    preProcess.setScaleFactor(Settings::getOcrScaleFactor());
-
-    // Get the click point relative to the cropped area
-    Point ptInCropRect(pt.x() - cropRect.left(), pt.y() - cropRect.top());
-    PIX *inPixs = preProcess.convertImageToPix(image);
-    PIX *pixs = preProcess.extractTextBlock(inPixs,
-                                            ptInCropRect.x,
-                                            ptInCropRect.y,
-                                            Settings::getTextLineCaptureLookahead(),
-                                            Settings::getTextLineCaptureLookbehind(),
-                                            Settings::getTextLineCaptureSearchRadius());
-
-    pixDestroy(&inPixs);
-
-    if(pixs == nullptr)
-    {
-        qDebug() << "performTextLineCapture failed";
-        return;
-    }
-
-    if(pixs->w <= (unsigned int)minOcrWidth || pixs->h <= (unsigned int)minOcrHeight)
-    {
-        pixDestroy(&pixs);
-        return;
-    }
-
-    if(Settings::getDebugSaveEnhancedImage())
-    {
-        QString savePath = getDebugImagePath("debug_enhanced.png");
-        QByteArray byteArray = savePath.toLocal8Bit();
-        pixWriteImpliedFormat(byteArray.constData(), pixs, 0, 0);
-    }
-
-    ocrEngine->setVerticalOrientation(isVertical);
-    setOcrEngineCommon();
-    QString ocrText = ocrEngine->performOcr(pixs, true);
-    pixDestroy(&pixs);
-
-    QRect boundingBox = preProcess.getBoundingRect();
-
-    QRect displayRect;
-    displayRect.setLeft(pt.x() - ptInCropRect.x + boundingBox.x() + 1);
-    displayRect.setTop(pt.y() - ptInCropRect.y + boundingBox.y() + 1);
-    displayRect.setRight(displayRect.left() + boundingBox.width());
-    displayRect.setBottom(displayRect.top() + boundingBox.height());
-
-    if(displayRect.width() > minOcrWidth && displayRect.height() > minOcrHeight)
-    {
-        autoCaptureBox.autoCapture(displayRect);
-        ocrText = postProcess(ocrText);
-        outputOcrText(ocrText);
-    }
+    requestHotkeyCapture(HotkeyCaptureRequest(TEXTLINE_CAPTURE, pt, cropRect, isVertical));
 }
 
 void MainWindow::performBubbleCapture(QPoint pt)
@@ -562,8 +668,6 @@ void MainWindow::performBubbleCapture(QPoint pt)
     int idealRectHeight = Settings::getBubbleCaptureHeight();
     int idealRectHalfHeight = idealRectHeight / 2;
 
-    captureTimestamp = QDateTime::currentDateTime();
-
     QString savedTextOrientation = Settings::getOcrTextOrientation();
 
     int totalScreenWidth = 0;
@@ -582,79 +686,189 @@ void MainWindow::performBubbleCapture(QPoint pt)
     cropRect.setRight(qMin(totalScreenWidth, pt.x() + idealRectHalfWidth));
     cropRect.setBottom(qMin(screenRect.height(), pt.y() + idealRectHalfHeight));
 
-    QImage image = UtilsImg::takeScreenshot(cropRect);
+    bool isVertical = false;
 
-    if(image.isNull())
+    if(UtilsLang::languageSupportsVerticalOrientation(Settings::getOcrLang())
+            && (savedTextOrientation == "Auto" || savedTextOrientation == "Vertical"))
     {
+        isVertical = true;
+    }
+
+    requestHotkeyCapture(HotkeyCaptureRequest(BUBBLE_CAPTURE, pt, cropRect, isVertical));
+}
+
+// Run a text line, forward text line or bubble capture in a separate thread so that
+// the GUI does not block on OCR. If a hotkey capture is already in progress, the request
+// is queued. Only the latest queued request is kept so that rapid repeated hotkey
+// presses result in a single extra capture.
+void MainWindow::requestHotkeyCapture(HotkeyCaptureRequest request)
+{
+    if(watcherHotkeyCapture.isRunning())
+    {
+        pendingHotkeyCapture = request;
+        hasPendingHotkeyCapture = true;
         return;
     }
 
-    if(Settings::getDebugSaveCaptureImage())
+    hasPendingHotkeyCapture = false;
+    captureTimestamp = QDateTime::currentDateTime();
+    prewarmTranslation();
+
+    // When OCR is done, the routine connected to watcherHotkeyCapture's finished() signal will be called.
+    QFuture<HotkeyCaptureResult> futureHotkeyCapture = QtConcurrent::run(&captureThreadPool, this, &MainWindow::ocrHotkeyCapture, request);
+    watcherHotkeyCapture.setFuture(futureHotkeyCapture);
+}
+
+void MainWindow::hotkeyCaptureComplete()
+{
+    HotkeyCaptureResult result = watcherHotkeyCapture.result();
+
+    if(result.displayRect.width() > minOcrWidth && result.displayRect.height() > minOcrHeight)
     {
-        image.save(getDebugImagePath("debug_capture.png"));
+        autoCaptureBox.autoCapture(result.displayRect);
+        QString ocrText = postProcess(result.ocrText);
+        outputOcrText(ocrText);
     }
 
-    bool isVertical = false;
+    if(hasPendingHotkeyCapture)
+    {
+        requestHotkeyCapture(pendingHotkeyCapture);
+    }
+}
 
-    if(UtilsLang::languageSupportsVerticalOrientation(Settings::getOcrLang())
-            && (savedTextOrientation == "Auto" || savedTextOrientation == "Vertical"))
+// Screenshot, pre-process and OCR the area of a hotkey capture. Runs in a separate thread.
+// Uses its own PreProcess instance so that it does not interfere with a running preview.
+MainWindow::HotkeyCaptureResult MainWindow::ocrHotkeyCapture(HotkeyCaptureRequest request)
+{
+    HotkeyCaptureResult result;
+    QRect cropRect = request.cropRect;
+    QPoint pt = request.pt;
+
+    QImage image = UtilsImg::takeScreenshot(cropRect);
+
+    if(image.isNull())
     {
-        isVertical = true;
+        return result;
+    }
+
+    if(Settings::getDebugSaveCaptureImage())
+    {
+        DebugImageWriter::getInstance().write(image, getDebugImagePath("debug_capture.png"));
     }
 
-    preProcess.setVerticalOrientation(isVertical);
-    preProcess.setRemoveFurigana(UtilsLang::languageSupportsFurigana(Settings::getOcrLang()));
-    preProcess.setScaleFactor(Settings::getOcrScaleFactor());
+    PreProcessOptions options;
+    options.scaleFactor = Settings::getOcrScaleFactor();
+    options.verticalText = request.isVertical;
+    options.removeFurigana = UtilsLang::languageSupportsFurigana(Settings::getOcrLang());
 
+    // Get the click point relative to the cropped area
     Point ptInCropRect(pt.x() - cropRect.left(), pt.y() - cropRect.top());
+    PreProcess preProcess(options);
     PIX *inPixs = preProcess.convertImageToPix(image);
-    PIX *pixs = preProcess.extractBubbleText(inPixs, ptInCropRect.x, ptInCropRect.y);
+    PreProcessResult preProcessResult;
+
+    if(inPixs == nullptr)
+    {
+        return result;
+    }
+
+    if(request.type == FORWARD_TEXTLINE_CAPTURE)
+    {
+        preProcessResult = PreProcess::extractTextBlock(inPixs,
+                                                        ptInCropRect.x,
+                                                        ptInCropRect.y,
+                                                        Settings::getForwardTextLineCaptureLookahead(),
+                                                        Settings::getForwardTextLineCaptureLookbehind(),
+                                                        Settings::getForwardTextLineCaptureSearchRadius(),
+                                                        options);
+    }
+    else if(request.type == TEXTLINE_CAPTURE)
+    {
+        preProcessResult = PreProcess::extractTextBlock(inPixs,
+                                                        ptInCropRect.x,
+                                                        ptInCropRect.y,
+                                                        Settings::getTextLineCaptureLookahead(),
+                                                        Settings::getTextLineCaptureLookbehind(),
+                                                        Settings::getTextLineCaptureSearchRadius(),
+                                                        options);
+    }
+    else
+    {
+        preProcessResult = PreProcess::extractBubbleText(inPixs, ptInCropRect.x, ptInCropRect.y, options);
+    }
+
     pixDestroy(&inPixs);
+    PIX *pixs = preProcessResult.pixs;
 
     if(pixs == nullptr)
     {
-        return;
+        qDebug() << "ocrHotkeyCapture failed";
+        return result;
     }
 
     if(pixs->w <= (unsigned int)minOcrWidth || pixs->h <= (unsigned int)minOcrHeight)
     {
         pixDestroy(&pixs);
-        return;
+        return result;
     }
 
     if(Settings::getDebugSaveEnhancedImage())
     {
-        QString savePath = getDebugImagePath("debug_enhanced.png");
-        QByteArray byteArray = savePath.toLocal8Bit();
-        pixWriteImpliedFormat(byteArray.constData(), pixs, 0, 0);
+        DebugImageWriter::getInstance().write(pixs, getDebugImagePath("debug_enhanced.png"));
     }
 
-    ocrEngine->setVerticalOrientation(isVertical);
-    setOcrEngineCommon();
+    // The options are passed with the OCR call, ocrEngine is shared with captures running at the same time
+    OcrOptions ocrOptions = getOcrOptions(request.isVertical);
+    QString ocrText;
 
-    bool singleLine = false;
+    if(request.type == BUBBLE_CAPTURE)
+    {
+        bool singleLine = false;
 
-    if(UtilsLang::languageSupportsFurigana(Settings::getOcrLang()))
+        if(UtilsLang::languageSupportsFurigana(Settings::getOcrLang()))
+        {
+            singleLine = (preProcessResult.numTextLines == 1);
+        }
+
+        if(Settings::getOcrParallelLines())
+        {
+            ocrText = ocrEnginePool.performOcr(ocrEngine, pixs, preProcessResult.scaleFactor, singleLine, ocrOptions);
+        }
+        else
+        {
+            ocrText = ocrEngine->performOcr(pixs, singleLine, ocrOptions);
+        }
+    }
+    else
     {
-        singleLine = (preProcess.getJapNumTextLines() == 1);
+        ocrText = ocrEngine->performOcr(pixs, true, ocrOptions);
     }
 
-    QString ocrText = ocrEngine->performOcr(pixs, singleLine);
     pixDestroy(&pixs);
 
-    QRect boundingBox = preProcess.getBoundingRect();
-    QRect displayRect;
-    displayRect.setLeft(cropRect.left() + boundingBox.x() + 1);
-    displayRect.setTop(cropRect.top() + boundingBox.y() + 1);
-    displayRect.setRight(displayRect.left() + boundingBox.width());
-    displayRect.setBottom(displayRect.top() + boundingBox.height());
-
-    if(displayRect.width() > minOcrWidth && displayRect.height() > minOcrHeight)
+    if(request.type == FORWARD_TEXTLINE_CAPTURE && Settings::getForwardTextLineCaptureFirstWord())
     {
-        autoCaptureBox.autoCapture(displayRect);
-        ocrText = postProcess(ocrText);
-        outputOcrText(ocrText);
+        if(ocrText.contains(' '))
+        {
+            ocrText = ocrText.left(ocrText.indexOf(' '));
+        }
+
+        if(ocrText.length() > 1)
+        {
+            ocrText = ocrText.trimmed();
+            ocrText = ocrText.replace(QRegularExpression("[\\.,!\\?;:]$"), "");
+        }
     }
+
+    QRect boundingBox = preProcessResult.boundingRect;
+
+    result.ocrText = ocrText;
+    result.displayRect.setLeft(cropRect.left() + boundingBox.x() + 1);
+    result.displayRect.setTop(cropRect.top() + boundingBox.y() + 1);
+    result.displayRect.setRight(result.displayRect.left() + boundingBox.width());
+    result.displayRect.setBottom(result.displayRect.top() + boundingBox.height());
+
+    return result;
 }
 
 void MainWindow::showDocumentation()
@@ -857,7 +1071,15 @@ void MainWindow::setOcrLang(QString lang) {
   }
 
   Settings::setOcrLang(lang);
-  QtConcurrent::run(ocrEngine, &OcrEngine::setLang, lang);
+
+  ocrEngine->setLangAsync(lang, OcrEngine::engineModeFromString(getEngineModeSetting(false)),
+                          getModelTierSetting(false));
+
+  // Otherwise previewEngine is loaded the first time getOcrEngine() selects it
+  if(Settings::getPreviewEnabled() && usePreviewEngine())
+  {
+    loadPreviewEngine();
+  }
 }
 
 void MainWindow::captureBoxMoved()
@@ -869,6 +1091,12 @@ void MainWindow::captureBoxMoved()
         return;
     }
 
+    // The full quality pass of a progressive preview is out of date once the box moves
+    if(watcherPreview.isRunning() && !previewFastPass && Settings::getPreviewProgressive())
+    {
+        previewCancel.store(1);
+    }
+
     QString savedPreviewPos = Settings::getPreviewPosition();
     QPoint pt(0, 0);
     int previewBoxHeight = previewBox.getBoxHeight();
@@ -913,6 +1141,16 @@ void MainWindow::captureBoxMoved()
 
 void MainWindow::ocrPreviewComplete()
 {
+    if(captureAttachedToPreview)
+    {
+        // The final capture was of the same rect as this preview. Now that the result of the
+        // preview is in previewChangeDetector, the capture can compare the screen against it.
+        captureAttachedToPreview = false;
+        QFuture<QString> futureCapture = QtConcurrent::run(&captureThreadPool, this, &MainWindow::ocrCaptureBoxArea, false);
+        watcherCapture.setFuture(futureCapture);
+        return;
+    }
+
     if(!Settings::getPreviewEnabled() || previewBox.isHidden())
     {
         return;
@@ -931,6 +1169,11 @@ void MainWindow::ocrPreviewComplete()
         pendingPreviewRequest = false;
         captureBoxStoppedMoving();
     }
+    else if(previewFastPass)
+    {
+        // Replace the text of the fast pass with a full quality pass
+        startPreview(false);
+    }
 }
 
 void MainWindow::captureBoxStoppedMoving()
@@ -955,15 +1198,25 @@ void MainWindow::captureBoxStoppedMoving()
     }
 
     pendingPreviewRequest = false;
+    startPreview(Settings::getPreviewProgressive());
+}
+
+void MainWindow::startPreview(bool fastPass)
+{
+    previewRect = captureBox.getCaptureRect();
+    previewFingerprint = getOcrSettingsFingerprint(true);
+    previewFastPass = fastPass;
+    previewCancel.store(0);
 
     // Run OCR for preview in separate thread so that capture box moving remains smooth.
     // When OCR is done, the routine connected to watcherPreview's finished() signal will be called.
-    QFuture<QString> futurePreview = QtConcurrent::run(this, &MainWindow::ocrCaptureBoxArea);
+    QFuture<QString> futurePreview = QtConcurrent::run(this, &MainWindow::ocrCaptureBoxArea, fastPass);
     watcherPreview.setFuture(futurePreview);
 }
 
 void MainWindow::captureBoxCancel()
 {
+    captureBox.releaseFrozenFrame();
     previewBox.hideAndReset();
 }
 
@@ -1019,6 +1272,35 @@ void MainWindow::translationComplete(QString phrase, QString translation, bool e
     }
 }
 
+// Return true if the capture or enhanced image of the final capture is saved for debugging.
+bool MainWindow::isDebugImageSaveEnabled()
+{
+    return Settings::getDebugSaveCaptureImage() || Settings::getDebugSaveEnhancedImage();
+}
+
+// Return true if the captured text will be translated.
+bool MainWindow::isTranslationEnabled()
+{
+    QString ocrLang = OcrEngine::altLangToLang(Settings::getOcrLang());
+    QString translateLang = Settings::getTranslateLang(Settings::getOcrLang());
+
+    return (Settings::getTranslateAddToClipboard()
+            || Settings::getTranslateAddToPopup()
+            || (Settings::getOutputLogFileEnable() && Settings::getOutputLogFormat().contains("${translation}"))
+            || (Settings::getOutputCallExeEnable()
+                && (Settings::getOutputCallExePersistent() || Settings::getOutputCallExe().contains("${translation}"))))
+        && ocrLang != "None" && translateLang != "<Do Not Translate>";
+}
+
+// Connect to the translation server while OCR is running.
+void MainWindow::prewarmTranslation()
+{
+    if(Settings::getTranslatePrewarm() && isTranslationEnabled())
+    {
+        translate.prewarmConnection();
+    }
+}
+
 void MainWindow::outputOcrText(QString text)
 {
     QString ocrLang = OcrEngine::altLangToLang(Settings::getOcrLang());
@@ -1026,11 +1308,7 @@ void MainWindow::outputOcrText(QString text)
 
     Speech::getInstance().sayText(text);
 
-    if((Settings::getTranslateAddToClipboard()
-           || Settings::getTranslateAddToPopup()
-           || (Settings::getOutputLogFileEnable() && Settings::getOutputLogFormat().contains("${translation}"))
-           || (Settings::getOutputCallExeEnable() && Settings::getOutputCallExe().contains("${translation}")))
-        && ocrLang != "None" && translateLang != "<Do Not Translate>")
+    if(isTranslationEnabled())
     {
         if(!translate.startTranslate(text, ocrLang, translateLang, Settings::getTranslateServerTimeout()))
         {
@@ -1083,9 +1361,9 @@ void MainWindow::outputOcrTextPhase2(QString text, QString translation)
 
     if(Settings::getOutputLogFileEnable())
     {
-        UtilsCommon::writeTextFile(Settings::getOutputLogFile(),
-                                   UtilsCommon::formatLogLine(Settings::getOutputLogFormat(), text, captureTimestamp, translation, ""),
-                                   true);
+        outputLogWriter.setFlushPolicy(OutputLogWriter::flushPolicyFromString(Settings::getOutputLogFlushPolicy()));
+        outputLogWriter.append(Settings::getOutputLogFile(),
+                               UtilsCommon::formatLogLine(Settings::getOutputLogFormat(), text, captureTimestamp, translation, ""));
     }
 
     if(Settings::getOutputCallExeEnable())
@@ -1094,11 +1372,25 @@ void MainWindow::outputOcrTextPhase2(QString text, QString translation)
 
         if(!action.isEmpty())
         {
-            action.replace("${capture}", text);
-            action.replace("${translation}", translation);
-            action.replace("${timestamp}", UtilsCommon::timestampToStr(captureTimestamp));
+            if(Settings::getOutputCallExePersistent())
+            {
+                // The worker is started once, the capture is sent to its stdin
+                QJsonObject record;
+                record["capture"] = text;
+                record["translation"] = translation;
+                record["timestamp"] = UtilsCommon::timestampToStr(captureTimestamp);
+                callExeWorker.send(action, record);
+            }
+            else
+            {
+                callExeWorker.stop();
 
-            QProcess::startDetached(action);
+                action.replace("${capture}", text);
+                action.replace("${translation}", translation);
+                action.replace("${timestamp}", UtilsCommon::timestampToStr(captureTimestamp));
+
+                QProcess::startDetached(action);
+            }
         }
     }
 }
@@ -27,11 +27,16 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 #include <QFutureWatcher>
 
 #include "AboutDialog.h"
+#include "CallExeWorker.h"
 #include "CaptureBox.h"
 #include "OcrEngine.h"
+#include "OcrEnginePool.h"
+#include "OutputLogWriter.h"
 #include "PopupDialog.h"
 #include "PreProcess.h"
 #include "Preview.h"
+#include "PreviewTileCache.h"
+#include "ScreenChangeDetector.h"
 #include "SettingsDialog.h"
 #include "Translate.h"
 #include "WelcomeDialog.h"
@@ -79,7 +84,11 @@ private:
     void captureBoxMoved();
     void captureBoxStoppedMoving();
     void captureBoxCancel();
-    QString ocrCaptureBoxArea();
+    QString ocrCaptureBoxArea(bool fastPass);
+    void startPreview(bool fastPass);
+    PreProcessResult preProcessIncrementalPreview(QRect captureRect, const QImage &frozenFrame,
+                                                  const PreProcessOptions &options,
+                                                  ScreenChangeDetector::Signature *signature);
     void ocrPreviewComplete();
     void ocrCaptureComplete();
     void settingsAccepted();
@@ -88,9 +97,39 @@ private:
     void checkCurrentTextOrientationInMenu();
     void outputOcrTextPhase2(QString text, QString translation);
     void translationComplete(QString phrase, QString translation, bool error);
-    void setOcrEngineCommon();
+    bool isDebugImageSaveEnabled();
+    bool isTranslationEnabled();
+    void prewarmTranslation();
+    OcrOptions getOcrOptions(bool verticalOrientation);
+    QString getOcrSettingsFingerprint(bool preview);
+    QString getEngineModeSetting(bool preview);
+    QString getModelTierSetting(bool preview);
+    bool usePreviewEngine();
+    OcrEngine *getOcrEngine(bool preview);
+    void loadPreviewEngine();
     QString getDebugImagePath(QString filename);
 
+    struct HotkeyCaptureRequest
+    {
+        HotkeyCaptureRequest(int type=0, QPoint pt=QPoint(), QRect cropRect=QRect(), bool isVertical=false)
+            : type(type), pt(pt), cropRect(cropRect), isVertical(isVertical) {}
+
+        int type;
+        QPoint pt;
+        QRect cropRect;
+        bool isVertical;
+    };
+
+    struct HotkeyCaptureResult
+    {
+        QString ocrText;
+        QRect displayRect;
+    };
+
+    void requestHotkeyCapture(HotkeyCaptureRequest request);
+    HotkeyCaptureResult ocrHotkeyCapture(HotkeyCaptureRequest request);
+    void hotkeyCaptureComplete();
+
     enum HotkeyAction
     {
         CAPTURE_BOX = 1000,
@@ -111,7 +150,16 @@ private:
     Preview previewBox;
     Preview infoBox;
     OcrEngine *ocrEngine;
-    PreProcess preProcess;
+    OcrEngine *previewEngine; // Used instead of ocrEngine for previews, see usePreviewEngine()
+    OcrEnginePool ocrEnginePool;
+    OcrEnginePool previewEnginePool;
+
+    // Final captures and hotkey captures run here rather than in the global thread pool,
+    // so they never wait for a thread held by a preview
+    QThreadPool captureThreadPool;
+    PreviewTileCache previewTileCache;
+    ScreenChangeDetector screenChangeDetector;
+    ScreenChangeDetector previewChangeDetector;
     QSystemTrayIcon *trayIcon;
     QDateTime captureTimestamp;
 
@@ -124,7 +172,24 @@ private:
     QFutureWatcher<QString> watcherPreview;
     bool pendingPreviewRequest;
 
+    // Capture rect and OCR settings of the preview in progress. If the final capture is
+    // of the same rect, it waits for that preview and reuses its result if the screen
+    // contents match exactly (see previewChangeDetector).
+    QRect previewRect;
+    QString previewFingerprint;
+    bool captureAttachedToPreview;
+
+    // Progressive preview: a fast low scale pass is followed by a full quality refinement,
+    // which is cancelled through previewCancel when the capture box moves
+    bool previewFastPass;
+    QAtomicInt previewCancel;
+
     QFutureWatcher<QString> watcherCapture;
+
+    QFutureWatcher<HotkeyCaptureResult> watcherHotkeyCapture;
+    HotkeyCaptureRequest pendingHotkeyCapture;
+    bool hasPendingHotkeyCapture;
+
     PopupDialog popupDialog;
     SettingsDialog settingsDialog;
     AboutDialog aboutDialog;
@@ -132,6 +197,9 @@ private:
 
     Translate translate;
 
+    OutputLogWriter outputLogWriter;
+    CallExeWorker callExeWorker;
+
     QList<QHotkey*> hotkeys;
 };
 
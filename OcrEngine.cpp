@@ -20,23 +20,24 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QtConcurrent/QtConcurrent>
 #include "OcrEngine.h"
-
-#include "Settings.h"
+#include "TessdataIndex.h"
 
 OcrEngine::OcrEngine()
-    : lang("English"),
-      whitelist(""),
-      blacklist(""),
-      configFile("")
+    : lang("English")
 {
     populateLangMap();
+
+    // No language is loaded until setLang() or setLangAsync() is called
     tessApi = new tesseract::TessBaseAPI();
-    setLang(Settings::defaultOcrLang);
 }
 
 OcrEngine::~OcrEngine()
 {
+    waitForLang();
     tessApi->End();
     delete tessApi;
 }
@@ -58,18 +59,11 @@ QString OcrEngine::getTessdataPath()
 
 QStringList OcrEngine::getInstalledLangs()
 {
-    QString path = getTessdataPath();
-    
-    QDir dir(path );
-    QStringList nameFilter("*.traineddata");
-    QStringList langFiles = dir.entryList(nameFilter);
+    QStringList langCodes = TessdataIndex::getInstance().getLangCodes();
     QStringList nameList;
 
-    foreach (const QString &file, langFiles)
+    foreach (const QString &langCode, langCodes)
     {
-        QString langCode = file;
-        langCode.replace(".traineddata", "");
-
         if(mapCode.contains(langCode))
         {
             nameList.append(mapCode.value(langCode));
@@ -83,28 +77,20 @@ QStringList OcrEngine::getInstalledLangs()
 
 bool OcrEngine::isLangInstalled(QString lang)
 {
-    QStringList installedLangs = getInstalledLangs();
-    return installedLangs.contains(lang);
-}
-
-bool OcrEngine::isLangCodeInstalled(QString langCode)
-{
-    QDir dir(getTessdataPath());
-    QStringList nameFilter("*.traineddata");
-    QStringList langFiles = dir.entryList(nameFilter);
+    QString langCode = mapLang.value(lang);
 
-    foreach (const QString &file, langFiles)
+    // A language name is listed as installed when its code maps back to it
+    if(langCode.isEmpty() || mapCode.value(langCode) != lang)
     {
-        QString langCodeInDir = file;
-        langCodeInDir.replace(".traineddata", "");
-
-        if(langCodeInDir == langCode)
-        {
-            return true;
-        }
+        return false;
     }
 
-    return false;
+    return TessdataIndex::getInstance().containsLangCode(langCode);
+}
+
+bool OcrEngine::isLangCodeInstalled(QString langCode)
+{
+    return TessdataIndex::getInstance().containsLangCode(langCode);
 }
 
 QString OcrEngine::getFirstInstalledLang()
@@ -119,9 +105,11 @@ QString OcrEngine::getFirstInstalledLang()
     return "None";
 }
 
-bool OcrEngine::setLang(QString lang)
+// Load the models of lang with the engine mode and model tier. Does nothing if they are
+// already loaded.
+bool OcrEngine::setLang(QString lang, tesseract::OcrEngineMode mode, QString modelTier)
 {
-    this->lang = lang;
+    modelTier = modelTier.trimmed();
 
     if(!mapLang.contains(lang))
     {
@@ -135,7 +123,14 @@ bool OcrEngine::setLang(QString lang)
 
     mutex.lock();
 
+    if(langLoaded && lang == this->lang && mode == engineMode && modelTier == this->modelTier)
+    {
+        mutex.unlock();
+        return true;
+    }
+
     tessApi->End();
+    langLoaded = false;
 
     QString langCode = mapLang.value(lang);
 
@@ -158,31 +153,264 @@ bool OcrEngine::setLang(QString lang)
         }
     }
 
-    QByteArray langCodeByteArray = langCode.toLocal8Bit();
-
     QString exeDirpath  =getTessdataPath();
+    QString modelPath = getModelPath(langCode, modelTier);
+    int initStatus = initTesseract(modelPath, langCode, mode);
+
+    // Models of the fast and best tiers are LSTM only and some engine modes need the legacy
+    // model, so fall back to the default engine mode and models of tessdata
+    if(initStatus != 0 && (modelPath != exeDirpath || mode != tesseract::OEM_DEFAULT))
+    {
+        qDebug() << "Unable to initialize OCR language with selected engine mode and model tier, using defaults: " << lang;
+        initStatus = initTesseract(exeDirpath, langCode, tesseract::OEM_DEFAULT);
+    }
 
-    if (tessApi->Init(exeDirpath.toLocal8Bit().constData(), langCodeByteArray.constData()))
+    if (initStatus != 0)
     {
         qDebug() << "Unable to initialize OCR language: " << lang;
+        resetOcrParams();
         mutex.unlock();
         return false;
     }
 
+    // Init() resets all parameters to their defaults
+    resetOcrParams();
+
+    langMutex.lock();
+    this->lang = lang;
+    engineMode = mode;
+    this->modelTier = modelTier;
+    langMutex.unlock();
+
+    langLoaded = true;
+
     mutex.unlock();
 
     return true;
 }
 
-QString OcrEngine::performOcr(PIX *pixs, bool singleTextLine)
+// Initialize Tesseract with the models of langCode in tessdataPath. Returns 0 on success.
+// Caller must hold the mutex.
+int OcrEngine::initTesseract(const QString &tessdataPath, const QString &langCode, tesseract::OcrEngineMode mode)
 {
+    QByteArray langCodeByteArray = langCode.toLocal8Bit();
+
+    return tessApi->Init(tessdataPath.toLocal8Bit().constData(), langCodeByteArray.constData(), mode);
+}
+
+// Get the directory of the model tier that contains all models of langCode (for example
+// "jpn+jpn_vert"). Falls back to tessdata if no tier is set or the tier lacks a model.
+QString OcrEngine::getModelPath(const QString &langCode, const QString &modelTier)
+{
+    QString tessdataPath = getTessdataPath();
+    QString tierPath = getTessdataPath(modelTier);
+
+    if(tierPath == tessdataPath)
+    {
+        return tessdataPath;
+    }
+
+    for(const QString &code : langCode.split('+'))
+    {
+        if(!QFile::exists(tierPath + QDir::separator() + code + ".traineddata"))
+        {
+            return tessdataPath;
+        }
+    }
+
+    return tierPath;
+}
+
+// Get the directory of the models of a tier, such as "fast" for tessdata_fast or "best"
+// for tessdata_best. Returns the tessdata directory if modelTier is empty or does not exist.
+QString OcrEngine::getTessdataPath(const QString &modelTier)
+{
+    QString path = getTessdataPath();
+
+    if(modelTier.isEmpty())
+    {
+        return path;
+    }
+
+    QString tierPath = path + "_" + modelTier.toLower();
+
+    if(!QDir(tierPath).exists())
+    {
+        return path;
+    }
+
+    return tierPath;
+}
+
+// Convert "LSTM", "Legacy", "Combined" or "Default" (case-insensitive) to an engine mode.
+tesseract::OcrEngineMode OcrEngine::engineModeFromString(const QString &mode, bool *ok)
+{
+    QString modeLower = mode.trimmed().toLower();
+    bool valid = true;
+    tesseract::OcrEngineMode engineMode = tesseract::OEM_DEFAULT;
+
+    if(modeLower == "lstm")
+    {
+        engineMode = tesseract::OEM_LSTM_ONLY;
+    }
+    else if(modeLower == "legacy")
+    {
+        engineMode = tesseract::OEM_TESSERACT_ONLY;
+    }
+    else if(modeLower == "combined")
+    {
+        engineMode = tesseract::OEM_TESSERACT_LSTM_COMBINED;
+    }
+    else if(modeLower != "default" && !modeLower.isEmpty())
+    {
+        valid = false;
+    }
+
+    if(ok != nullptr)
+    {
+        *ok = valid;
+    }
+
+    return engineMode;
+}
+
+// Load lang in a background thread. Loads run in the order they were requested and
+// OCR calls made before the last load is done wait for it. A load equal to the last one
+// requested is not queued again.
+void OcrEngine::setLangAsync(QString lang, tesseract::OcrEngineMode mode, QString modelTier)
+{
+    QMutexLocker locker(&langLoadMutex);
+
+    modelTier = modelTier.trimmed();
+
+    if(langLoadRequested && lang == requestedLang && mode == requestedEngineMode && modelTier == requestedModelTier)
+    {
+        return;
+    }
+
+    langLoadRequested = true;
+    requestedLang = lang;
+    requestedEngineMode = mode;
+    requestedModelTier = modelTier;
+
+    QFuture<bool> previousLoad = langLoad;
+
+    langLoad = QtConcurrent::run([this, previousLoad, lang, mode, modelTier]() mutable
+    {
+        previousLoad.waitForFinished();
+        return setLang(lang, mode, modelTier);
+    });
+}
+
+// Wait for a language load started by setLangAsync() to finish.
+void OcrEngine::waitForLang()
+{
+    langLoadMutex.lock();
+    QFuture<bool> load = langLoad;
+    langLoadMutex.unlock();
+
+    load.waitForFinished();
+}
+
+// OCR the pre-processed image with the provided options. If cancel is provided, recognition
+// stops early once it is set to a non-zero value. If it was cancelled, the returned text
+// is incomplete and the caller should discard it.
+QString OcrEngine::performOcr(PIX *pixs, bool singleTextLine, const OcrOptions &options, QAtomicInt *cancel)
+{
+    waitForLang();
+
     mutex.lock();
 
     tessApi->SetImage(pixs);
+    setOcrParams(singleTextLine, options);
+
+    if(cancel != nullptr)
+    {
+#if defined(TESSERACT_MAJOR_VERSION) && TESSERACT_MAJOR_VERSION >= 5
+        tesseract::ETEXT_DESC monitor;
+#else
+        ETEXT_DESC monitor;
+#endif
+        monitor.cancel = &OcrEngine::cancelCallback;
+        monitor.cancel_this = cancel;
+
+        if(tessApi->Recognize(&monitor) < 0 || cancel->load() != 0)
+        {
+            tessApi->Clear();
+            mutex.unlock();
+            return QString();
+        }
+    }
+
+    char *outText = tessApi->GetUTF8Text();
+    QString ocrText(outText);
+
+    tessApi->Clear();
+
+    //with this line ,vs crash.
+    delete [] outText;
+
+    mutex.unlock();
+
+    return ocrText;
+}
+
+// Called by Tesseract during recognition, returns true to stop recognizing.
+bool OcrEngine::cancelCallback(void *cancelThis, int /*words*/)
+{
+    return static_cast<QAtomicInt *>(cancelThis)->load() != 0;
+}
 
-    if(verticalOrientation)
+// OCR several regions of the same pre-processed image. The image is handed to
+// Tesseract once and each region is selected with SetRectangle(), so no per-region
+// copies of the image are needed. Returns one string per region, in the provided order.
+// If cancel is provided and set to non-zero, the remaining regions are returned empty.
+QStringList OcrEngine::performOcr(PIX *pixs, const QList<QRect> &regions, bool singleTextLine,
+                                  const OcrOptions &options, QAtomicInt *cancel)
+{
+    QStringList ocrTextList;
+    QRect imageRect(0, 0, pixs->w, pixs->h);
+
+    waitForLang();
+
+    mutex.lock();
+
+    tessApi->SetImage(pixs);
+    setOcrParams(singleTextLine, options);
+
+    for(const QRect &region : regions)
+    {
+        QRect clippedRegion = region.intersected(imageRect);
+
+        if(clippedRegion.isEmpty() || (cancel != nullptr && cancel->load() != 0))
+        {
+            ocrTextList.append("");
+            continue;
+        }
+
+        tessApi->SetRectangle(clippedRegion.x(), clippedRegion.y(),
+                              clippedRegion.width(), clippedRegion.height());
+
+        char *outText = tessApi->GetUTF8Text();
+        ocrTextList.append(QString(outText));
+        delete [] outText;
+    }
+
+    tessApi->Clear();
+
+    mutex.unlock();
+
+    return ocrTextList;
+}
+
+// Apply the page segmentation mode and variables for the next recognition.
+// Only parameters that differ from the ones already applied are passed to Tesseract.
+// Caller must hold the mutex.
+void OcrEngine::setOcrParams(bool singleTextLine, const OcrOptions &options)
+{
+    if(options.verticalOrientation)
     {
-        tessApi->SetPageSegMode(tesseract::PageSegMode::PSM_SINGLE_BLOCK_VERT_TEXT);
+        setPageSegMode(tesseract::PageSegMode::PSM_SINGLE_BLOCK_VERT_TEXT);
 
         // For Japanese and Chinese apply configuration that will improve accuracy
         if (lang == "Japanese"
@@ -190,21 +418,21 @@ QString OcrEngine::performOcr(PIX *pixs, bool singleTextLine)
                 || lang == "Chinese - Traditional")
         {
             bool status = true;
-            status =  tessApi->SetVariable("tessedit_enable_dict_correction",  "1"     );
-            status &= tessApi->SetVariable("textord_really_old_xheight",       "1"     );
-            status &= tessApi->SetVariable("tosp_threshold_bias2",             "1"     );
-            status &= tessApi->SetVariable("classify_norm_adj_midpoint",       "96"    );
-            status &= tessApi->SetVariable("tessedit_class_miss_scale",        "0.002" );
-            status &= tessApi->SetVariable("textord_initialx_ile",             "1.0"   );
+            status =  setVariable("tessedit_enable_dict_correction",  "1"     );
+            status &= setVariable("textord_really_old_xheight",       "1"     );
+            status &= setVariable("tosp_threshold_bias2",             "1"     );
+            status &= setVariable("classify_norm_adj_midpoint",       "96"    );
+            status &= setVariable("tessedit_class_miss_scale",        "0.002" );
+            status &= setVariable("textord_initialx_ile",             "1.0"   );
 
             if(singleTextLine)
             {
-                status &= tessApi->SetVariable("textord_min_linesize",         "2.5"   );
+                status &= setVariable("textord_min_linesize",         "2.5"   );
             }
             else
             {
                 // For higher values of textord_min_linesize, Tesseract will get confused when lines are close together
-                status &= tessApi->SetVariable("textord_min_linesize",         "2.0"   );
+                status &= setVariable("textord_min_linesize",         "2.0"   );
             }
 
             if(!status)
@@ -217,33 +445,116 @@ QString OcrEngine::performOcr(PIX *pixs, bool singleTextLine)
     {
         if(singleTextLine)
         {
-            tessApi->SetPageSegMode(tesseract::PageSegMode::PSM_SINGLE_LINE);
+            setPageSegMode(tesseract::PageSegMode::PSM_SINGLE_LINE);
         }
         else
         {
-            tessApi->SetPageSegMode(tesseract::PageSegMode::PSM_SINGLE_BLOCK);
+            setPageSegMode(tesseract::PageSegMode::PSM_SINGLE_BLOCK);
         }
     }
 
-    tessApi->SetVariable("tessedit_char_whitelist", whitelist.toLocal8Bit().constData());
-    tessApi->SetVariable("tessedit_char_blacklist", blacklist.toLocal8Bit().constData());
+    setVariable("tessedit_char_whitelist", options.whitelist);
+    setVariable("tessedit_char_blacklist", options.blacklist);
 
-    if(configFile.length() > 0 && QFile::exists(configFile))
+    applyConfigFile(options.configFile.trimmed());
+}
+
+// Caller must hold the mutex.
+void OcrEngine::setPageSegMode(tesseract::PageSegMode mode)
+{
+    if(appliedPageSegMode != mode)
     {
-        tessApi->ReadConfigFile(configFile.toLocal8Bit().constData());
+        tessApi->SetPageSegMode(mode);
+        appliedPageSegMode = mode;
     }
+}
 
-    char *outText = tessApi->GetUTF8Text();
-    QString ocrText(outText);
+// Set a Tesseract variable if it is not already set to value.
+// Caller must hold the mutex.
+bool OcrEngine::setVariable(const QString &name, const QString &value)
+{
+    auto it = appliedVariables.constFind(name);
 
-    tessApi->Clear();
+    if(it != appliedVariables.constEnd() && it.value() == value)
+    {
+        return true;
+    }
 
-    //with this line ,vs crash.
-    delete [] outText;
+    bool status = tessApi->SetVariable(name.toLocal8Bit().constData(), value.toLocal8Bit().constData());
 
-    mutex.unlock();
+    if(status)
+    {
+        appliedVariables.insert(name, value);
+    }
 
-    return ocrText;
+    return status;
+}
+
+// Apply the variables of the Tesseract config file. The file is only parsed again
+// when it changes. Caller must hold the mutex.
+void OcrEngine::applyConfigFile(const QString &configFile)
+{
+    if(configFile.length() == 0)
+    {
+        return;
+    }
+
+    QFileInfo fileInfo(configFile);
+
+    if(!fileInfo.exists())
+    {
+        return;
+    }
+
+    if(configFile != parsedConfigFile || fileInfo.lastModified() != parsedConfigFileModified)
+    {
+        parsedConfigFile = configFile;
+        parsedConfigFileModified = fileInfo.lastModified();
+        configVariables.clear();
+
+        QFile file(configFile);
+
+        if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            QTextStream in(&file);
+
+            // Same format as read by TessBaseAPI::ReadConfigFile(): one "name value" per line,
+            // lines that are empty or start with '#' are ignored
+            while(!in.atEnd())
+            {
+                QString line = in.readLine();
+
+                if(line.isEmpty() || line.startsWith('#'))
+                {
+                    continue;
+                }
+
+                int sepIndex = line.indexOf(QRegExp("\\s"));
+
+                if(sepIndex == 0)
+                {
+                    continue;
+                }
+
+                QString name = (sepIndex < 0) ? line : line.left(sepIndex);
+                QString value = (sepIndex < 0) ? QString() : line.mid(sepIndex).trimmed();
+                configVariables.append(qMakePair(name, value));
+            }
+        }
+    }
+
+    for(const auto &variable : configVariables)
+    {
+        setVariable(variable.first, variable.second);
+    }
+}
+
+// Forget the applied parameters, used after Tesseract resets them.
+// Caller must hold the mutex.
+void OcrEngine::resetOcrParams()
+{
+    appliedPageSegMode = -1;
+    appliedVariables.clear();
 }
 
 QString OcrEngine::altLangToLang(QString ocrLang)
@@ -20,63 +20,110 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef OCR_ENGINE_H
 #define OCR_ENGINE_H
 
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QFuture>
 #include <QString>
 #include <QStringList>
+#include <QList>
 #include <QMap>
 #include <QMutex>
+#include <QPair>
 #include <QRect>
 
 #if defined( Q_OS_WIN32 ) || defined( Q_OS_MAC )
 #include "tesseract/baseapi.h"
+#include "tesseract/ocrclass.h"
 #else
 #include "baseapi.h"
+#include "ocrclass.h"
 #endif
 
 
 #include "allheaders.h"
 
+// Options of a single recognition. They are passed with each performOcr() call rather than
+// set on the engine, so captures that share an engine cannot change each other's options.
+struct OcrOptions
+{
+    bool verticalOrientation = false;
+    QString whitelist;
+    QString blacklist;
+    QString configFile;
+};
+
 class OcrEngine
 {
 public:
     OcrEngine();
     ~OcrEngine();
     static QString getTessdataPath();
+    static QString getTessdataPath(const QString &modelTier);
+    static tesseract::OcrEngineMode engineModeFromString(const QString &mode, bool *ok=nullptr);
     static QStringList getInstalledLangs();
     static bool isLangInstalled(QString lang);
     static QString getFirstInstalledLang();
-    bool setLang(QString lang);
-    QString performOcr(PIX *pixs, bool singleLine);
-
-    QString getLang() { return lang; }
-    bool getVerticalOrientation() const { return verticalOrientation; }
-    void setVerticalOrientation(bool value) { verticalOrientation = value; }
+    bool setLang(QString lang, tesseract::OcrEngineMode mode=tesseract::OEM_DEFAULT, QString modelTier=QString());
+    void setLangAsync(QString lang, tesseract::OcrEngineMode mode=tesseract::OEM_DEFAULT, QString modelTier=QString());
+    void waitForLang();
+    QString performOcr(PIX *pixs, bool singleLine, const OcrOptions &options, QAtomicInt *cancel=nullptr);
+    QStringList performOcr(PIX *pixs, const QList<QRect> &regions, bool singleLine, const OcrOptions &options,
+                           QAtomicInt *cancel=nullptr);
+
+    // Language, engine mode and model tier of the last successful setLang()
+    QString getLang() const { QMutexLocker locker(&langMutex); return lang; }
+    tesseract::OcrEngineMode getEngineMode() const { QMutexLocker locker(&langMutex); return engineMode; }
+    QString getModelTier() const { QMutexLocker locker(&langMutex); return modelTier; }
 
     static QString altLangToLang(QString ocrLang);
 
-    QString getWhitelist() const { return whitelist; }
-    void setWhitelist(const QString &value) { whitelist = value; }
-
-    QString getBlacklist() const { return blacklist; }
-    void setBlacklist(const QString &value) { blacklist = value; }
-
-    QString getConfigFile() const { return configFile; }
-    void setConfigFile(const QString &value) { configFile = value.trimmed(); }
-
 private:
+    static bool cancelCallback(void *cancelThis, int words);
+
     bool isLangCodeInstalled(QString langCode);
+    void setOcrParams(bool singleTextLine, const OcrOptions &options);
+    void setPageSegMode(tesseract::PageSegMode mode);
+    bool setVariable(const QString &name, const QString &value);
+    void applyConfigFile(const QString &configFile);
+    void resetOcrParams();
+    int initTesseract(const QString &tessdataPath, const QString &langCode, tesseract::OcrEngineMode mode);
+    QString getModelPath(const QString &langCode, const QString &modelTier);
 
     static QMap<QString, QString> populateLangMap();
     static QMap<QString, QString> populateCodeMap();
     static QMap<QString, QString> populateAltLangMap();
 
     QMutex mutex;
+
+    // Language load started by setLangAsync() and what it was asked to load
+    QMutex langLoadMutex;
+    QFuture<bool> langLoad;
+    bool langLoadRequested = false;
+    QString requestedLang;
+    tesseract::OcrEngineMode requestedEngineMode = tesseract::OEM_DEFAULT;
+    QString requestedModelTier;
+
+    // Guards lang, engineMode and modelTier, which are written under the mutex as well so
+    // that the getters do not wait for a running recognition
+    mutable QMutex langMutex;
     QString lang;
-    bool verticalOrientation = false;
-    QString whitelist;
-    QString blacklist;
-    QString configFile;
+    tesseract::OcrEngineMode engineMode = tesseract::OEM_DEFAULT;
+    QString modelTier;
+
+    // Whether tessApi holds the models of lang, engineMode and modelTier
+    bool langLoaded = false;
 
     tesseract::TessBaseAPI *tessApi;
+
+    // Parameters last applied to tessApi, so that only changes need to be applied.
+    // Tesseract keeps them until the next Init().
+    int appliedPageSegMode = -1;
+    QMap<QString, QString> appliedVariables;
+
+    // Variables parsed from the Tesseract config file and its modification time when parsed
+    QString parsedConfigFile;
+    QDateTime parsedConfigFileModified;
+    QList<QPair<QString, QString>> configVariables;
     static const QMap<QString, QString> mapLang; // Key = Lang name, Value = Tesseract Code
     static const QMap<QString, QString> mapCode; // Key = Tesseract Code, Value = Lang name
     static const QMap<QString, QString> mapLangAlt; // Key = Alt Lang name, Value = Lang name
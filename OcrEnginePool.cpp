@@ -0,0 +1,154 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDebug>
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+#include "OcrEnginePool.h"
+#include "Furigana.h"
+
+OcrEnginePool::OcrEnginePool()
+    : maxEngines(qMax(qMin(QThread::idealThreadCount(), 4), 1))
+{
+    threadPool.setMaxThreadCount(maxEngines);
+}
+
+OcrEnginePool::~OcrEnginePool()
+{
+    for(auto &engines : helperEngines)
+    {
+        qDeleteAll(engines);
+    }
+}
+
+// OCR the provided pre-processed (1 bpp) image one text line at a time, spreading the
+// lines over several engines. Lines are found with the furigana span analysis and the
+// text is reassembled in reading order (top to bottom, or right to left for vertical text).
+// Falls back to a regular single block OCR on mainEngine when there are too few lines.
+// If cancel is provided and set to non-zero, the OCR stops early and the text is incomplete.
+QString OcrEnginePool::performOcr(OcrEngine *mainEngine, PIX *pixs, float scaleFactor, bool singleLine,
+                                  const OcrOptions &options, QAtomicInt *cancel)
+{
+    if(singleLine || maxEngines < 2 || pixs->d != 1)
+    {
+        return mainEngine->performOcr(pixs, singleLine, options, cancel);
+    }
+
+    QList<QRect> lines = Furigana::findTextLines(pixs, scaleFactor, options.verticalOrientation);
+
+    if(lines.size() < minLines)
+    {
+        return mainEngine->performOcr(pixs, singleLine, options, cancel);
+    }
+
+    // The helper engines are set to the language of mainEngine, make sure it is loaded
+    mainEngine->waitForLang();
+
+    mutex.lock();
+
+    int numEngines = qMin(maxEngines, lines.size());
+    QList<OcrEngine *> engines;
+    engines.append(mainEngine);
+    engines.append(getHelperEngines(mainEngine, numEngines - 1));
+
+    // Interleave the lines between the engines so that the work is balanced
+    QList<QList<QRect>> linesPerEngine;
+
+    for(int i = 0; i < engines.size(); i++)
+    {
+        linesPerEngine.append(QList<QRect>());
+    }
+
+    for(int i = 0; i < lines.size(); i++)
+    {
+        linesPerEngine[i % engines.size()].append(lines[i]);
+    }
+
+    // Each engine gets its own copy of the image. Leptonica reference counts are
+    // not thread safe, so the same PIX must not be handed to several engines at once.
+    QStringList (OcrEngine::*performOcrRegions)(PIX *, const QList<QRect> &, bool, const OcrOptions &, QAtomicInt *)
+            = &OcrEngine::performOcr;
+    QList<PIX *> pixCopies;
+    QList<QFuture<QStringList>> futures;
+
+    for(int i = 0; i < engines.size(); i++)
+    {
+        PIX *enginePixs = pixCopy(nullptr, pixs);
+        pixCopies.append(enginePixs);
+        futures.append(QtConcurrent::run(&threadPool, engines[i], performOcrRegions,
+                                         enginePixs, linesPerEngine[i], true, options, cancel));
+    }
+
+    QStringList textPerLine;
+
+    for(int i = 0; i < lines.size(); i++)
+    {
+        textPerLine.append("");
+    }
+
+    for(int i = 0; i < futures.size(); i++)
+    {
+        QStringList engineText = futures[i].result();
+
+        for(int j = 0; j < engineText.size(); j++)
+        {
+            textPerLine[j * engines.size() + i] = engineText[j].trimmed();
+        }
+
+        pixDestroy(&pixCopies[i]);
+    }
+
+    mutex.unlock();
+
+    textPerLine.removeAll("");
+
+    return textPerLine.join("\n");
+}
+
+// Return count helper engines that are configured like mainEngine, creating them if needed.
+// Caller must hold the mutex.
+QList<OcrEngine *> OcrEnginePool::getHelperEngines(OcrEngine *mainEngine, int count)
+{
+    // Engines of another language will not be used again
+    if(helperLang != mainEngine->getLang())
+    {
+        for(auto &engines : helperEngines)
+        {
+            qDeleteAll(engines);
+        }
+
+        helperEngines.clear();
+        helperLang = mainEngine->getLang();
+    }
+
+    tesseract::OcrEngineMode engineMode = mainEngine->getEngineMode();
+    QString modelTier = mainEngine->getModelTier();
+    QString configKey = QString("%1|%2").arg((int)engineMode).arg(modelTier);
+    QList<OcrEngine *> &configEngines = helperEngines[configKey];
+
+    while(configEngines.size() < count)
+    {
+        OcrEngine *engine = new OcrEngine();
+        engine->setLang(helperLang, engineMode, modelTier);
+        configEngines.append(engine);
+    }
+
+    return configEngines.mid(0, count);
+}
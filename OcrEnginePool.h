@@ -0,0 +1,71 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OCR_ENGINE_POOL_H
+#define OCR_ENGINE_POOL_H
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QRect>
+#include <QString>
+#include <QThreadPool>
+
+#include "OcrEngine.h"
+
+// Splits a pre-processed image into text lines and recognizes the lines in parallel
+// on several OCR engines. The engines are created on first use and are configured
+// to match the engine passed to performOcr(), which also takes part in the work.
+// The options of the recognition are passed to every engine with each call.
+// Each pool runs the work on its own threads, so separate pools do not wait for each other.
+class OcrEnginePool
+{
+public:
+    OcrEnginePool();
+    ~OcrEnginePool();
+
+    QString performOcr(OcrEngine *mainEngine, PIX *pixs, float scaleFactor, bool singleLine,
+                       const OcrOptions &options, QAtomicInt *cancel=nullptr);
+
+    int getMaxEngines() const { return maxEngines; }
+    void setMaxEngines(int value) { maxEngines = qMax(value, 1); threadPool.setMaxThreadCount(maxEngines); }
+
+    int getMinLines() const { return minLines; }
+    void setMinLines(int value) { minLines = qMax(value, 2); }
+
+private:
+    QList<OcrEngine *> getHelperEngines(OcrEngine *mainEngine, int count);
+
+    QMutex mutex;
+
+    // Helper engines per engine mode and model tier, all set to helperLang. Keeping a set
+    // per configuration avoids reloading models when captures alternate between configurations.
+    QMap<QString, QList<OcrEngine *>> helperEngines;
+    QString helperLang;
+    QThreadPool threadPool;
+
+    // Maximum number of engines (including the main engine) that work on a capture
+    int maxEngines;
+
+    // Captures with fewer lines than this are recognized as a single block
+    int minLines = 3;
+};
+
+#endif // OCR_ENGINE_POOL_H
@@ -0,0 +1,211 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDebug>
+#include "OutputLogWriter.h"
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+OutputLogWriter::OutputLogWriter()
+    : flushPolicy(FlushPolicy::Flush),
+      writing(false),
+      flushRequested(false),
+      stopping(false)
+{
+
+}
+
+OutputLogWriter::~OutputLogWriter()
+{
+    mutex.lock();
+    stopping = true;
+    workAvailable.wakeAll();
+    mutex.unlock();
+
+    // The thread writes the remaining queue and closes the file before it exits
+    wait();
+}
+
+void OutputLogWriter::append(const QString &file, const QString &text)
+{
+    QMutexLocker locker(&mutex);
+
+    queue.enqueue({ file, text });
+
+    if(!isRunning())
+    {
+        start(QThread::LowPriority);
+    }
+
+    workAvailable.wakeOne();
+}
+
+void OutputLogWriter::flush()
+{
+    QMutexLocker locker(&mutex);
+
+    if(!isRunning())
+    {
+        return;
+    }
+
+    flushRequested = true;
+    workAvailable.wakeOne();
+
+    while(!queue.isEmpty() || writing || flushRequested)
+    {
+        workDone.wait(&mutex);
+    }
+}
+
+void OutputLogWriter::setFlushPolicy(FlushPolicy policy)
+{
+    QMutexLocker locker(&mutex);
+    flushPolicy = policy;
+}
+
+// Convert the value of the Output/LogFlushPolicy setting ("None", "Flush" or "Sync").
+OutputLogWriter::FlushPolicy OutputLogWriter::flushPolicyFromString(const QString &policy)
+{
+    if(policy.compare("None", Qt::CaseInsensitive) == 0)
+    {
+        return FlushPolicy::None;
+    }
+    else if(policy.compare("Sync", Qt::CaseInsensitive) == 0)
+    {
+        return FlushPolicy::Sync;
+    }
+
+    return FlushPolicy::Flush;
+}
+
+void OutputLogWriter::run()
+{
+    mutex.lock();
+
+    while(true)
+    {
+        if(queue.isEmpty() && !stopping && !flushRequested)
+        {
+            if(!logFile.isOpen())
+            {
+                workAvailable.wait(&mutex);
+            }
+            else if(!workAvailable.wait(&mutex, idleCloseMs) && queue.isEmpty())
+            {
+                mutex.unlock();
+                closeFile();
+                mutex.lock();
+            }
+
+            continue;
+        }
+
+        if(queue.isEmpty() && stopping)
+        {
+            break;
+        }
+
+        // Take everything queued so far and write it as one batch
+        QQueue<Entry> batch;
+        batch.swap(queue);
+        FlushPolicy policy = flushPolicy;
+        bool flushBatch = flushRequested;
+        writing = true;
+        mutex.unlock();
+
+        for(const Entry &entry : batch)
+        {
+            if(openFile(entry.file))
+            {
+                logFile.write(entry.text.toUtf8());
+            }
+        }
+
+        if(logFile.isOpen() && (policy != FlushPolicy::None || flushBatch))
+        {
+            logFile.flush();
+
+            if(policy == FlushPolicy::Sync)
+            {
+                syncFile();
+            }
+        }
+
+        mutex.lock();
+        writing = false;
+
+        if(flushBatch)
+        {
+            flushRequested = false;
+        }
+
+        workDone.wakeAll();
+    }
+
+    mutex.unlock();
+    closeFile();
+}
+
+// Make sure path is the open file. Returns false if it can not be opened.
+bool OutputLogWriter::openFile(const QString &path)
+{
+    if(logFile.isOpen() && logFile.fileName() == path)
+    {
+        return true;
+    }
+
+    closeFile();
+    logFile.setFileName(path);
+
+    if(!logFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        qWarning() << "Unable to open log file:" << path << logFile.errorString();
+        return false;
+    }
+
+    // New or empty file
+    if(logFile.size() == 0)
+    {
+        logFile.write("\xEF\xBB\xBF");
+    }
+
+    return true;
+}
+
+void OutputLogWriter::closeFile()
+{
+    if(logFile.isOpen())
+    {
+        logFile.close();
+    }
+}
+
+void OutputLogWriter::syncFile()
+{
+#ifdef Q_OS_WIN
+    _commit(logFile.handle());
+#else
+    fsync(logFile.handle());
+#endif
+}
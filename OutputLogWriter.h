@@ -0,0 +1,85 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OUTPUT_LOG_WRITER_H
+#define OUTPUT_LOG_WRITER_H
+
+#include <QFile>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+// Appends OCR output to the log file on a background thread. The file stays open between
+// captures and all lines queued since the last write are written together. A UTF-8 BOM
+// is only written when the file is created (or is empty). The file is closed again
+// after a few seconds without output so that it can be moved or deleted by the user.
+class OutputLogWriter : public QThread
+{
+public:
+    enum class FlushPolicy
+    {
+        None,  // Leave data in the file buffer until it fills up or the file is closed
+        Flush, // Hand each batch to the OS, so it survives an application crash
+        Sync   // Also sync each batch to disk, so it survives a power failure
+    };
+
+    OutputLogWriter();
+    ~OutputLogWriter();
+
+    void append(const QString &file, const QString &text);
+
+    // Wait until all queued text is written and flushed
+    void flush();
+
+    void setFlushPolicy(FlushPolicy policy);
+    static FlushPolicy flushPolicyFromString(const QString &policy);
+
+protected:
+    void run();
+
+private:
+    struct Entry
+    {
+        QString file;
+        QString text;
+    };
+
+    bool openFile(const QString &path);
+    void closeFile();
+    void syncFile();
+
+    // Close the file after this much time without output
+    static const int idleCloseMs = 5000;
+
+    QMutex mutex;
+    QWaitCondition workAvailable;
+    QWaitCondition workDone;
+    QQueue<Entry> queue;
+    FlushPolicy flushPolicy;
+    bool writing;
+    bool flushRequested;
+    bool stopping;
+
+    // Only used by the writer thread
+    QFile logFile;
+};
+
+#endif // OUTPUT_LOG_WRITER_H
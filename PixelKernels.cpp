@@ -0,0 +1,366 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PixelKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_KERNELS_SSE2
+#include <emmintrin.h>
+
+#if defined(_MSC_VER) || defined(__GNUC__)
+#define PIXEL_KERNELS_AVX2
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#endif
+
+// Same weights as pixConvertRGBToGray() uses when all weights are 0
+static const l_float32 redWeight = L_RED_WEIGHT;
+static const l_float32 greenWeight = L_GREEN_WEIGHT;
+static const l_float32 blueWeight = L_BLUE_WEIGHT;
+
+static void grayRow32Scalar(const l_uint32 *src, l_uint32 *dst, int start, int width)
+{
+    for(int x = start; x < width; x++)
+    {
+        l_uint32 word = src[x];
+        SET_DATA_BYTE(dst, x, PixelKernels::grayValue((word >> L_RED_SHIFT) & 0xff,
+                                                      (word >> L_GREEN_SHIFT) & 0xff,
+                                                      (word >> L_BLUE_SHIFT) & 0xff));
+    }
+}
+
+static void grayRow24Scalar(const l_uint32 *src, l_uint32 *dst, int width)
+{
+    // 24 bpp pixels are stored as R, G, B bytes in memory order
+    const l_uint8 *bytes = (const l_uint8 *)src;
+
+    for(int x = 0; x < width; x++, bytes += 3)
+    {
+        SET_DATA_BYTE(dst, x, PixelKernels::grayValue(bytes[0], bytes[1], bytes[2]));
+    }
+}
+
+static void thresholdRowScalar(const l_uint32 *src, l_uint32 *dst, int start, int width, int thresh)
+{
+    for(int x = start; x < width; x++)
+    {
+        if((int)GET_DATA_BYTE(src, x) < thresh)
+        {
+            SET_DATA_BIT(dst, x);
+        }
+    }
+}
+
+// 8 bpp rows hold 4 pixels per word with the first pixel in the most significant byte,
+// 1 bpp rows hold 32 pixels per word with the first pixel in the most significant bit.
+// On little-endian x86 both orders are reversed in memory, which the kernels undo.
+static inline l_uint32 reverseNibbles(l_uint32 mask)
+{
+    mask = ((mask >> 24) & 0x000000ff) | ((mask >> 8) & 0x0000ff00)
+            | ((mask << 8) & 0x00ff0000) | ((mask << 24) & 0xff000000);
+    return ((mask & 0x0f0f0f0f) << 4) | ((mask >> 4) & 0x0f0f0f0f);
+}
+
+#ifdef PIXEL_KERNELS_SSE2
+
+// Reverse the bytes of each 32 bit word
+static inline __m128i byteSwap32Sse2(__m128i v)
+{
+    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+// Gray values of 4 RGBA pixels as 32 bit integers
+static inline __m128i gray4Sse2(__m128i words)
+{
+    const __m128i byteMask = _mm_set1_epi32(0xff);
+    __m128 r = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(words, L_RED_SHIFT), byteMask));
+    __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(words, L_GREEN_SHIFT), byteMask));
+    __m128 b = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(words, L_BLUE_SHIFT), byteMask));
+    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(redWeight)),
+                                       _mm_mul_ps(g, _mm_set1_ps(greenWeight))),
+                            _mm_mul_ps(b, _mm_set1_ps(blueWeight)));
+
+    // Round in double precision like the scalar expression
+    const __m128d half = _mm_set1_pd(0.5);
+    __m128i lo = _mm_cvttpd_epi32(_mm_add_pd(_mm_cvtps_pd(sum), half));
+    __m128i hi = _mm_cvttpd_epi32(_mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(sum, sum)), half));
+    return _mm_unpacklo_epi64(lo, hi);
+}
+
+static void grayRow32Sse2(const l_uint32 *src, l_uint32 *dst, int width)
+{
+    int x = 0;
+
+    for(; x + 8 <= width; x += 8)
+    {
+        __m128i gray0 = gray4Sse2(_mm_loadu_si128((const __m128i *)(src + x)));
+        __m128i gray1 = gray4Sse2(_mm_loadu_si128((const __m128i *)(src + x + 4)));
+        __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(gray0, gray1), _mm_setzero_si128());
+        _mm_storel_epi64((__m128i *)(dst + x / 4), byteSwap32Sse2(bytes));
+    }
+
+    grayRow32Scalar(src, dst, x, width);
+}
+
+static void thresholdRowSse2(const l_uint32 *src, l_uint32 *dst, int width, int thresh)
+{
+    // Unsigned compare done as a signed compare with the sign bits flipped
+    const __m128i signBit = _mm_set1_epi8((char)0x80);
+    const __m128i threshold = _mm_set1_epi8((char)(thresh ^ 0x80));
+    int x = 0;
+
+    for(; x + 32 <= width; x += 32)
+    {
+        __m128i pixels0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + x / 4)), signBit);
+        __m128i pixels1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + x / 4 + 4)), signBit);
+        l_uint32 mask = (l_uint32)_mm_movemask_epi8(_mm_cmplt_epi8(pixels0, threshold))
+                | ((l_uint32)_mm_movemask_epi8(_mm_cmplt_epi8(pixels1, threshold)) << 16);
+        dst[x / 32] = reverseNibbles(mask);
+    }
+
+    thresholdRowScalar(src, dst, x, width, thresh);
+}
+
+#endif // PIXEL_KERNELS_SSE2
+
+#ifdef PIXEL_KERNELS_AVX2
+
+// Gray values of 8 RGBA pixels as 16 bit integers
+TARGET_AVX2
+static inline __m128i gray8Avx2(__m256i words)
+{
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+    __m256 r = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(words, L_RED_SHIFT), byteMask));
+    __m256 g = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(words, L_GREEN_SHIFT), byteMask));
+    __m256 b = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(words, L_BLUE_SHIFT), byteMask));
+    __m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, _mm256_set1_ps(redWeight)),
+                                             _mm256_mul_ps(g, _mm256_set1_ps(greenWeight))),
+                               _mm256_mul_ps(b, _mm256_set1_ps(blueWeight)));
+
+    // Round in double precision like the scalar expression
+    const __m256d half = _mm256_set1_pd(0.5);
+    __m128i lo = _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(sum)), half));
+    __m128i hi = _mm256_cvttpd_epi32(_mm256_add_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(sum, 1)), half));
+    return _mm_packs_epi32(lo, hi);
+}
+
+TARGET_AVX2
+static void grayRow32Avx2(const l_uint32 *src, l_uint32 *dst, int width)
+{
+    const __m128i byteSwap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    int x = 0;
+
+    for(; x + 16 <= width; x += 16)
+    {
+        __m128i gray0 = gray8Avx2(_mm256_loadu_si256((const __m256i *)(src + x)));
+        __m128i gray1 = gray8Avx2(_mm256_loadu_si256((const __m256i *)(src + x + 8)));
+        __m128i bytes = _mm_packus_epi16(gray0, gray1);
+        _mm_storeu_si128((__m128i *)(dst + x / 4), _mm_shuffle_epi8(bytes, byteSwap));
+    }
+
+    grayRow32Scalar(src, dst, x, width);
+}
+
+TARGET_AVX2
+static void thresholdRowAvx2(const l_uint32 *src, l_uint32 *dst, int width, int thresh)
+{
+    // Unsigned compare done as a signed compare with the sign bits flipped
+    const __m256i signBit = _mm256_set1_epi8((char)0x80);
+    const __m256i threshold = _mm256_set1_epi8((char)(thresh ^ 0x80));
+    int x = 0;
+
+    for(; x + 32 <= width; x += 32)
+    {
+        __m256i pixels = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(src + x / 4)), signBit);
+        l_uint32 mask = (l_uint32)_mm256_movemask_epi8(_mm256_cmpgt_epi8(threshold, pixels));
+        dst[x / 32] = reverseNibbles(mask);
+    }
+
+    thresholdRowScalar(src, dst, x, width, thresh);
+}
+
+static bool cpuSupportsAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+
+    if(info[0] < 7)
+    {
+        return false;
+    }
+
+    // AVX must be enabled by the OS (OSXSAVE set and the YMM state saved)
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+
+    if(!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // PIXEL_KERNELS_AVX2
+
+static PixelKernels::Isa detectIsa()
+{
+#if defined(PIXEL_KERNELS_AVX2)
+    if(cpuSupportsAvx2())
+    {
+        return PixelKernels::Isa::AVX2;
+    }
+#endif
+
+#if defined(PIXEL_KERNELS_SSE2)
+    return PixelKernels::Isa::SSE2;
+#else
+    return PixelKernels::Isa::Scalar;
+#endif
+}
+
+PixelKernels::Isa PixelKernels::getIsa()
+{
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+// Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+PIX *PixelKernels::convertRGBToGray(PIX *pixs)
+{
+    if(pixs == nullptr || (pixGetDepth(pixs) != 32 && pixGetDepth(pixs) != 24))
+    {
+        return nullptr;
+    }
+
+    int width = pixGetWidth(pixs);
+    int height = pixGetHeight(pixs);
+    PIX *pixd = pixCreate(width, height, 8);
+
+    if(pixd == nullptr)
+    {
+        return nullptr;
+    }
+
+    pixCopyResolution(pixd, pixs);
+
+    const l_uint32 *datas = pixGetData(pixs);
+    l_uint32 *datad = pixGetData(pixd);
+    int wpls = pixGetWpl(pixs);
+    int wpld = pixGetWpl(pixd);
+    bool is24 = (pixGetDepth(pixs) == 24);
+    Isa isa = getIsa();
+
+    for(int y = 0; y < height; y++)
+    {
+        const l_uint32 *lines = datas + y * wpls;
+        l_uint32 *lined = datad + y * wpld;
+
+        if(is24)
+        {
+            grayRow24Scalar(lines, lined, width);
+        }
+#ifdef PIXEL_KERNELS_AVX2
+        else if(isa == Isa::AVX2)
+        {
+            grayRow32Avx2(lines, lined, width);
+        }
+#endif
+#ifdef PIXEL_KERNELS_SSE2
+        else if(isa == Isa::SSE2)
+        {
+            grayRow32Sse2(lines, lined, width);
+        }
+#endif
+        else
+        {
+            grayRow32Scalar(lines, lined, 0, width);
+        }
+    }
+
+    return pixd;
+}
+
+// Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+PIX *PixelKernels::thresholdToBinary(PIX *pixs, int thresh)
+{
+    if(pixs == nullptr || pixGetDepth(pixs) != 8 || pixGetColormap(pixs) != nullptr
+            || thresh < 0 || thresh > 256)
+    {
+        return nullptr;
+    }
+
+    int width = pixGetWidth(pixs);
+    int height = pixGetHeight(pixs);
+    PIX *pixd = pixCreate(width, height, 1);
+
+    if(pixd == nullptr)
+    {
+        return nullptr;
+    }
+
+    pixCopyResolution(pixd, pixs);
+
+    const l_uint32 *datas = pixGetData(pixs);
+    l_uint32 *datad = pixGetData(pixd);
+    int wpls = pixGetWpl(pixs);
+    int wpld = pixGetWpl(pixd);
+
+    // The vector compare works on bytes, so 256 (all pixels) is left to the scalar code
+    Isa isa = (thresh <= 255) ? getIsa() : Isa::Scalar;
+
+    for(int y = 0; y < height; y++)
+    {
+        const l_uint32 *lines = datas + y * wpls;
+        l_uint32 *lined = datad + y * wpld;
+
+#ifdef PIXEL_KERNELS_AVX2
+        if(isa == Isa::AVX2)
+        {
+            thresholdRowAvx2(lines, lined, width, thresh);
+            continue;
+        }
+#endif
+#ifdef PIXEL_KERNELS_SSE2
+        if(isa == Isa::SSE2)
+        {
+            thresholdRowSse2(lines, lined, width, thresh);
+            continue;
+        }
+#endif
+        thresholdRowScalar(lines, lined, 0, width, thresh);
+    }
+
+    return pixd;
+}
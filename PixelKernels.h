@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIXEL_KERNELS_H
+#define PIXEL_KERNELS_H
+
+#include "allheaders.h"
+
+// Per-pixel conversions used by the pre-processing pipeline, with SSE2 and AVX2
+// versions selected at runtime and a scalar fallback. The output is identical to
+// the leptonica function that each kernel replaces.
+class PixelKernels
+{
+public:
+    enum class Isa
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // Best instruction set supported by both the build and the CPU
+    static Isa getIsa();
+
+    // Gray value of a single pixel, same expression as pixConvertRGBToGray() with the
+    // default weights: the weighted sum is a float, the 0.5 is a double
+    static inline l_int32 grayValue(l_int32 rval, l_int32 gval, l_int32 bval)
+    {
+        return (l_int32)((l_float32)L_RED_WEIGHT * rval + (l_float32)L_GREEN_WEIGHT * gval
+                         + (l_float32)L_BLUE_WEIGHT * bval + 0.5);
+    }
+
+    // Convert a 32 bpp or 24 bpp RGB image to 8 bpp. Same as pixConvertRGBToGray()
+    // with the default weights (24 bpp images are read directly, without pixConvert24To32()).
+    // Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+    static PIX *convertRGBToGray(PIX *pixs);
+
+    // Convert an 8 bpp image without colormap to 1 bpp. Pixels below thresh become
+    // foreground. Same as pixThresholdToBinary().
+    // Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+    static PIX *thresholdToBinary(PIX *pixs, int thresh);
+
+private:
+    PixelKernels() {}
+};
+
+#endif // PIXEL_KERNELS_H
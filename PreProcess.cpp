@@ -19,10 +19,14 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QBuffer>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QtGlobal>
 #include "PreProcess.h"
 #include "BoundingTextRect.h"
+#include "ConnComp.h"
+#include "DebugImageWriter.h"
 #include "Furigana.h"
+#include "PixelKernels.h"
 
 PreProcess::PreProcess()
     : verticalText(false),
@@ -31,6 +35,78 @@ PreProcess::PreProcess()
 
 }
 
+PreProcess::PreProcess(const PreProcessOptions &options)
+    : verticalText(options.verticalText),
+      removeFurigana(options.removeFurigana)
+{
+    setScaleFactor(options.scaleFactor);
+}
+
+// Standard pre-process for OCR. See processImage(PIX *, bool, bool).
+PreProcessResult PreProcess::processImage(PIX *pixs, const PreProcessOptions &options)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    PreProcess preProcess(options);
+    PIX *pixResult = preProcess.processImage(pixs, options.deskew, options.trim);
+
+    return preProcess.makeResult(pixResult, false, timer.elapsed());
+}
+
+// Standard pre-process for OCR of an already scaled image. See processScaledImage(PIX *, PIX *, bool, bool).
+PreProcessResult PreProcess::processScaledImage(PIX *pixGray, PIX *pixScaled, const PreProcessOptions &options)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    PreProcess preProcess(options);
+    PIX *pixResult = preProcess.processScaledImage(pixGray, pixScaled, options.deskew, options.trim);
+
+    return preProcess.makeResult(pixResult, false, timer.elapsed());
+}
+
+// Extract the text line near a point. See extractTextBlock(PIX *, int, int, int, int, int).
+PreProcessResult PreProcess::extractTextBlock(PIX *pixs, int pt_x, int pt_y, int lookahead, int lookbehind,
+                                              int searchRadius, const PreProcessOptions &options)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    PreProcess preProcess(options);
+    PIX *pixResult = preProcess.extractTextBlock(pixs, pt_x, pt_y, lookahead, lookbehind, searchRadius);
+
+    return preProcess.makeResult(pixResult, true, timer.elapsed());
+}
+
+// Extract the text of the bubble around a point. See extractBubbleText(PIX *, int, int).
+PreProcessResult PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y, const PreProcessOptions &options)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    PreProcess preProcess(options);
+    PIX *pixResult = preProcess.extractBubbleText(pixs, pt_x, pt_y);
+
+    return preProcess.makeResult(pixResult, true, timer.elapsed());
+}
+
+PreProcessResult PreProcess::makeResult(PIX *pixs, bool hasBoundingRect, qint64 elapsedMs) const
+{
+    PreProcessResult result;
+    result.pixs = pixs;
+    result.scaleFactor = scaleFactor;
+    result.numTextLines = japNumTextLines;
+    result.elapsedMs = elapsedMs;
+
+    if(hasBoundingRect && pixs != nullptr)
+    {
+        result.boundingRect = getBoundingRect();
+    }
+
+    return result;
+}
+
 QRect PreProcess::getBoundingRect() const
 {
     return QRect(boundingRect.x / scaleFactor,
@@ -104,8 +180,7 @@ void PreProcess::debugImg(QString filename, PIX *pixs)
         debugImgCount++;
         QString file = QString("G:\\Temp\\Temp\\c2t_debug\\%1_%2")
                 .arg(debugImgCount, 2, 10, QChar('0')).arg(filename);
-        QByteArray ba = file.toLocal8Bit();
-        pixWriteImpliedFormat(ba.constData(), pixs, 0, 0);
+        DebugImageWriter::getInstance().write(pixs, file);
     }
 #else
     Q_UNUSED(filename);
@@ -155,15 +230,9 @@ PIX *PreProcess::makeGray(PIX *pixs)
 {
     PIX *pixGray = nullptr;
 
-    if(pixs->d == 32)
-    {
-        pixGray = pixConvertRGBToGray(pixs, 0.0f, 0.0f, 0.0f);
-    }
-    else if(pixs->d == 24)
+    if(pixs->d == 32 || pixs->d == 24)
     {
-        PIX *pix32bpp = pixConvert24To32(pixs);
-        pixGray = pixConvertRGBToGray(pix32bpp, 0.0f, 0.0f, 0.0f);
-        pixDestroy(&pix32bpp);
+        pixGray = PixelKernels::convertRGBToGray(pixs);
     }
     else
     {
@@ -229,9 +298,30 @@ PIX *PreProcess::binarize(PIX *pixs)
     PIX *binarize_pixs = nullptr;
 
 #if 1
-    int status = pixOtsuAdaptiveThreshold(pixs, otsuSX, otsuSY, otsuSmoothX, otsuSmoothY, otsuScorefract, nullptr, &binarize_pixs);
+    int status = LEPT_ERROR;
 
-    if (status != LEPT_OK)
+    if ((int)pixs->w < 2 * otsuSX && (int)pixs->h < 2 * otsuSY && pixGetColormap(pixs) == nullptr)
+    {
+        // The image is a single tile, so there is only one threshold. Let leptonica
+        // find it and apply it with the vectorized kernel.
+        PIX *thresh_pixs = nullptr;
+        status = pixOtsuAdaptiveThreshold(pixs, otsuSX, otsuSY, otsuSmoothX, otsuSmoothY, otsuScorefract, &thresh_pixs, nullptr);
+
+        if (status == LEPT_OK)
+        {
+            l_uint32 thresh = 0;
+            pixGetPixel(thresh_pixs, 0, 0, &thresh);
+            binarize_pixs = PixelKernels::thresholdToBinary(pixs, (int)thresh);
+        }
+
+        pixDestroy(&thresh_pixs);
+    }
+    else
+    {
+        status = pixOtsuAdaptiveThreshold(pixs, otsuSX, otsuSY, otsuSmoothX, otsuSmoothY, otsuScorefract, nullptr, &binarize_pixs);
+    }
+
+    if (status != LEPT_OK || binarize_pixs == nullptr)
     {
         debugMsg("binarize: failed!");
         return nullptr;
@@ -285,6 +375,24 @@ PIX *PreProcess::scaleUnsharpBinarize(PIX *pixs)
     return binarize_pixs;
 }
 
+// pixs must be 8 bpp.
+// Scale and unsharp mask, the grayscale part of scaleUnsharpBinarize().
+// Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+PIX *PreProcess::scaleUnsharp(PIX *pixs)
+{
+    PIX *scaled_pixs = scale(pixs);
+
+    if (scaled_pixs == nullptr)
+    {
+        return nullptr;
+    }
+
+    PIX *unsharp_pixs = unsharpMask(scaled_pixs);
+    pixDestroy(&scaled_pixs);
+
+    return unsharp_pixs;
+}
+
 // Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
 PIX *PreProcess::deskew(PIX *pixs)
 {
@@ -335,9 +443,8 @@ PIX *PreProcess::removeNoise(PIX *pixs)
     //int minBlobSize = (int)(1.86 * scaleFactor);
     int minBlobSize = 3;
 
-    // Remove noise if both dimensions are less than minBlobSize (yes, L_SELECT_IF_EITHER is correct here).
-    PIX *denoisePixs1 = pixSelectBySize(pixs, minBlobSize, minBlobSize, 8,
-                                        L_SELECT_IF_EITHER, L_SELECT_IF_GT, nullptr);
+    // Remove noise if both dimensions are less than minBlobSize
+    PIX *denoisePixs1 = ConnComp(pixs, 8).select(false, minBlobSize);
 
     if (denoisePixs1 == nullptr)
     {
@@ -427,12 +534,77 @@ PIX *PreProcess::processImage(PIX *pixs, bool performDeskew, bool trim)
         return nullptr;
     }
 
+    // If background is dark
+    if (isDarkBackground(pixGray))
+    {
+        // Negate image (yes, input and output can be the same PIX)
+        pixInvert(pixGray, pixGray);
+
+        if (pixGray == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    // Scale, Unsharp Mask, Binarize
+    PIX *pixBinarize = scaleUnsharpBinarize(pixGray);
+    pixDestroy(&pixGray);
+
+    if (pixBinarize == nullptr)
+    {
+        return nullptr;
+    }
+
+    return finishProcessImage(pixBinarize, performDeskew, trim);
+}
+
+// Standard pre-process for OCR, starting from an image that has already been converted
+// to grayscale, scaled and unsharp masked (see scaleUnsharp()). pixGray is the grayscale
+// image before scaling and is only used to determine whether the background is dark.
+// Neither input is modified.
+// Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+PIX *PreProcess::processScaledImage(PIX *pixGray, PIX *pixScaled, bool performDeskew, bool trim)
+{
+    debugImgCount = 0;
+
+    PIX *pixUnsharp = nullptr;
+
+    // If background is dark
+    if (isDarkBackground(pixGray))
+    {
+        pixUnsharp = pixInvert(nullptr, pixScaled);
+    }
+    else
+    {
+        pixUnsharp = pixClone(pixScaled);
+    }
+
+    if (pixUnsharp == nullptr)
+    {
+        return nullptr;
+    }
+
+    PIX *pixBinarize = binarize(pixUnsharp);
+    pixDestroy(&pixUnsharp);
+
+    if (pixBinarize == nullptr)
+    {
+        return nullptr;
+    }
+
+    return finishProcessImage(pixBinarize, performDeskew, trim);
+}
+
+// Determine whether the provided 8 bpp image has light text on a dark background
+// by looking at the binarized border pixels.
+bool PreProcess::isDarkBackground(PIX *pixGray)
+{
     // Binarize for negate determination
     PIX *binarizeForNegPixs = binarize(pixGray);
 
     if (binarizeForNegPixs == nullptr)
     {
-        return nullptr;
+        return false;
     }
 
     float pixelAvg = 0.0f;
@@ -448,27 +620,13 @@ PIX *PreProcess::processImage(PIX *pixs, bool performDeskew, bool trim)
 
     pixDestroy(&binarizeForNegPixs);
 
-    // If background is dark
-    if (pixelAvg > darkBgThreshold)
-    {
-        // Negate image (yes, input and output can be the same PIX)
-        pixInvert(pixGray, pixGray);
-
-        if (pixGray == nullptr)
-        {
-            return nullptr;
-        }
-    }
-
-    // Scale, Unsharp Mask, Binarize
-    PIX *pixBinarize = scaleUnsharpBinarize(pixGray);
-    pixDestroy(&pixGray);
-
-    if (pixBinarize == nullptr)
-    {
-        return nullptr;
-    }
+    return (pixelAvg > darkBgThreshold);
+}
 
+// Deskew, erase furigana and trim a binarized image. Takes ownership of pixBinarize.
+// Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+PIX *PreProcess::finishProcessImage(PIX *pixBinarize, bool performDeskew, bool trim)
+{
     // Deskew
     if(performDeskew)
     {
@@ -524,12 +682,18 @@ PIX *PreProcess::processImage(PIX *pixs, bool performDeskew, bool trim)
 
 
 // Extract the text block closest to the provided point.
+// The text block is located at the native resolution of pixs; only the located
+// block (plus a small margin) is scaled, sharpened and binarized for OCR.
 // Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
 PIX *PreProcess::extractTextBlock(PIX *pixs, int pt_x, int pt_y, int lookahead, int lookbehind, int searchRadius)
 {
     debugImgCount = 0;
     int status = LEPT_ERROR;
 
+    // Native pixels kept around the located block so that scaling and unsharp
+    // masking have context at the edges of the block
+    const int blockMargin = 4;
+
     // Convert to grayscale
     PIX *pixGray = makeGray(pixs);
 
@@ -545,6 +709,7 @@ PIX *PreProcess::extractTextBlock(PIX *pixs, int pt_x, int pt_y, int lookahead,
 
     if (binarizeForNegPixs == nullptr)
     {
+        pixDestroy(&pixGray);
         return nullptr;
     }
 
@@ -565,7 +730,6 @@ PIX *PreProcess::extractTextBlock(PIX *pixs, int pt_x, int pt_y, int lookahead,
 
     float pixelAvg = 0.0f;
     status = pixAverageInRect(binarizeForNegPixs, NULL, &negRect, 0, 255, 1, &pixelAvg);
-    pixDestroy(&binarizeForNegPixs);
 
     // qDebug() << "Pixel Avg: " << pixelAvg;
 
@@ -581,60 +745,85 @@ PIX *PreProcess::extractTextBlock(PIX *pixs, int pt_x, int pt_y, int lookahead,
         // Negate image (yes, input and output can be the same PIX)
         pixInvert(pixGray, pixGray);
 
-        if (pixGray == nullptr)
-        {
-            return nullptr;
-        }
+        // The native binarization is used to locate the text, negate it to match
+        pixInvert(binarizeForNegPixs, binarizeForNegPixs);
     }
 
-    // Scale, Unsharp Mark, Binarize
-    PIX *binarizePixs = scaleUnsharpBinarize(pixGray);
-    pixDestroy(&pixGray);
+    // In one labeling pass, remove black pixels connected to the border (this eliminates
+    // annoying things like text bubbles in manga) and single pixel noise.
+    // The blob size of removeNoise() is meant for scaled images.
+    PIX *denoisePixs = ConnComp(binarizeForNegPixs, 8).select(true, 1);
+    pixDestroy(&binarizeForNegPixs);
 
-    if (binarizePixs == nullptr)
+    if (denoisePixs == nullptr)
     {
+        debugMsg("ConnComp select failed!");
+        pixDestroy(&pixGray);
         return nullptr;
     }
 
-    // Remove black pixels connected to the border.
-    // This eliminates annoying things like text bubbles in manga.
-    PIX *connCompsPixs = pixRemoveBorderConnComps(binarizePixs, 8);
+    debugImg("denoisePixs.png", denoisePixs);
+
+    // Get rectangle surrounding the text to extract (in native coordinates)
+    BOX blockRect = BoundingTextRect::getBoundingRect(denoisePixs,
+                                                      pt_x,
+                                                      pt_y,
+                                                      verticalText,
+                                                      lookahead,
+                                                      lookbehind,
+                                                      searchRadius);
+    pixDestroy(&denoisePixs);
 
-    if (connCompsPixs == nullptr)
+    // Same limit as when the rect was searched for in the scaled image
+    if(blockRect.w * scaleFactor < 3 && blockRect.h * scaleFactor < 3)
     {
-        debugMsg("pixRemoveBorderConnComps failed!");
+        pixDestroy(&pixGray);
+        debugMsg("BoundingRect too small!");
         return nullptr;
     }
 
-    debugImg("connCompsPixs.png", connCompsPixs);
+    // The w and h of the rect from getBoundingRect() are one less than the extent of the text
+    int blockWidth = blockRect.w + 1;
+    int blockHeight = blockRect.h + 1;
 
-    // Remove noise
-    PIX *denoisePixs = removeNoise(connCompsPixs);
-    pixDestroy(&connCompsPixs);
+    // Clip the block plus margin from the grayscale image
+    BOX marginRect;
+    marginRect.x = qMax(0, blockRect.x - blockMargin);
+    marginRect.y = qMax(0, blockRect.y - blockMargin);
+    marginRect.w = qMin((int)pixGray->w, blockRect.x + blockWidth + blockMargin) - marginRect.x;
+    marginRect.h = qMin((int)pixGray->h, blockRect.y + blockHeight + blockMargin) - marginRect.y;
 
-    if (denoisePixs == nullptr)
+    PIX *blockGrayPixs = pixClipRectangle(pixGray, &marginRect, nullptr);
+    pixDestroy(&pixGray);
+
+    if (blockGrayPixs == nullptr)
     {
+        debugMsg("pixClipRectangle failed!");
         return nullptr;
     }
 
-    // Get rectangle surrounding the text to extract
-    boundingRect = BoundingTextRect::getBoundingRect(denoisePixs,
-                                                     pt_x * scaleFactor,
-                                                     pt_y * scaleFactor,
-                                                     verticalText,
-                                                     lookahead * scaleFactor,
-                                                     lookbehind * scaleFactor,
-                                                     searchRadius * scaleFactor);
-    pixDestroy(&denoisePixs);
+    // Scale, Unsharp Mark, Binarize only the block
+    PIX *binarizePixs = scaleUnsharpBinarize(blockGrayPixs);
+    pixDestroy(&blockGrayPixs);
 
-    if(boundingRect.w < 3 && boundingRect.h < 3)
+    if (binarizePixs == nullptr)
     {
-        pixDestroy(&binarizePixs);
-        debugMsg("BoundingRect too small!");
         return nullptr;
     }
 
-    PIX *croppedPixs = pixClipRectangle(binarizePixs, &boundingRect, nullptr);
+    // Drop the margin again. boundingRect is in scaled coordinates of the whole image.
+    boundingRect.x = (int)(blockRect.x * scaleFactor);
+    boundingRect.y = (int)(blockRect.y * scaleFactor);
+    boundingRect.w = (int)(blockWidth * scaleFactor);
+    boundingRect.h = (int)(blockHeight * scaleFactor);
+
+    BOX blockInMarginRect;
+    blockInMarginRect.x = boundingRect.x - (int)(marginRect.x * scaleFactor);
+    blockInMarginRect.y = boundingRect.y - (int)(marginRect.y * scaleFactor);
+    blockInMarginRect.w = boundingRect.w;
+    blockInMarginRect.h = boundingRect.h;
+
+    PIX *croppedPixs = pixClipRectangle(binarizePixs, &blockInMarginRect, nullptr);
     pixDestroy(&binarizePixs);
 
     if (croppedPixs == nullptr)
@@ -687,15 +876,14 @@ PIX *PreProcess::extractTextBlock(PIX *pixs, int pt_x, int pt_y, int lookahead,
 
 
 // Extract all text within an enclosed area such as a comic book speech/thought bubble.
+// The bubble is segmented at the native resolution of pixs; only the clipped bubble
+// is scaled, sharpened and binarized for OCR.
 // Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
 PIX *PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y)
 {
     debugImgCount = 0;
     l_int32 status = LEPT_ERROR;
 
-    pt_x = (int)(pt_x * scaleFactor);
-    pt_y = (int)(pt_y * scaleFactor);
-
     // Convert to grayscale
     PIX *grayPixs = makeGray(pixs);
 
@@ -704,12 +892,12 @@ PIX *PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y)
         return nullptr;
     }
 
-    // Scale, Unsharp Mark, Binarize
-    PIX *binarizePixs = scaleUnsharpBinarize(grayPixs);
-    pixDestroy(&grayPixs);
+    // Binarize at native resolution for the segmentation
+    PIX *binarizePixs = binarize(grayPixs);
 
     if (binarizePixs == nullptr)
     {
+        pixDestroy(&grayPixs);
         return nullptr;
     }
 
@@ -720,6 +908,8 @@ PIX *PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y)
     if (status != LEPT_OK)
     {
         debugMsg("pixGetPixel failed!");
+        pixDestroy(&grayPixs);
+        pixDestroy(&binarizePixs);
         return nullptr;
     }
 
@@ -727,12 +917,6 @@ PIX *PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y)
     if (startPtIsBlack)
     {
         pixInvert(binarizePixs, binarizePixs);
-
-        if (binarizePixs == nullptr)
-        {
-            debugMsg("pixInvert failed!");
-            return nullptr;
-        }
     }
 
     // Create the seed start point
@@ -741,24 +925,23 @@ PIX *PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y)
     if (seedStartPixs == nullptr)
     {
         debugMsg("pixCreateTemplate failed!");
+        pixDestroy(&grayPixs);
+        pixDestroy(&binarizePixs);
         return nullptr;
     }
 
-    status = pixSetPixel(seedStartPixs, pt_x, pt_y, 1);
-
-    if (status != LEPT_OK)
-    {
-        debugMsg("pixSetPixel failed!");
-        return nullptr;
-    }
+    pixSetPixel(seedStartPixs, pt_x, pt_y, 1);
 
     // Dilate to thicken lines and connect small gaps in the bubble
-    int thickenAmount = (int)(2 * scaleFactor);
+    const int thickenAmount = 2;
     PIX *thickenLinesPixs = pixDilateBrick(nullptr, binarizePixs, thickenAmount, thickenAmount);
+    pixDestroy(&binarizePixs);
 
     if (thickenLinesPixs == nullptr)
     {
-        debugMsg("pixMorphSequence failed!");
+        debugMsg("pixDilateBrick failed!");
+        pixDestroy(&grayPixs);
+        pixDestroy(&seedStartPixs);
         return nullptr;
     }
 
@@ -771,6 +954,8 @@ PIX *PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y)
     if (binarizeNegPixs == nullptr)
     {
         debugMsg("pixInvert failed!");
+        pixDestroy(&grayPixs);
+        pixDestroy(&seedStartPixs);
         return nullptr;
     }
 
@@ -782,6 +967,7 @@ PIX *PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y)
     if (seedFillPixs == nullptr)
     {
         debugMsg("pixSeedfillBinary failed!");
+        pixDestroy(&grayPixs);
         return nullptr;
     }
 
@@ -790,31 +976,84 @@ PIX *PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y)
     // Negate seed fill
     pixInvert(seedFillPixs, seedFillPixs);
 
-    if (seedFillPixs == nullptr)
-    {
-        debugMsg("pixInvert 2 failed!");
-        return nullptr;
-    }
-
     debugImg("seedFillPixs_Neg.png", seedFillPixs);
 
-    // Remove foreground pixels touching the border
-    PIX *noBorderPixs = pixRemoveBorderConnComps(seedFillPixs, 8);
+    // Remove foreground pixels touching the border. What remains is the bubble interior.
+    PIX *noBorderPixs = ConnComp(seedFillPixs, 8).select(true, 0);
     pixDestroy(&seedFillPixs);
 
     if (noBorderPixs == nullptr)
     {
-        debugMsg("pixRemoveBorderConnComps failed!");
+        debugMsg("ConnComp select failed!");
+        pixDestroy(&grayPixs);
         return nullptr;
     }
 
     debugImg("noBorderPixs.png", noBorderPixs);
 
-    // AND with original binary image to remove everything except for the text
-    PIX *andPixs = pixAnd(nullptr, noBorderPixs, binarizePixs);
-    pixDestroy(&binarizePixs);
+    // Clip the bubble from the mask and from the grayscale image
+    PIX *bubbleMaskPixs = nullptr;
+    BOX *bubbleBox = nullptr;
+    status = pixClipToForeground(noBorderPixs, &bubbleMaskPixs, &bubbleBox);
     pixDestroy(&noBorderPixs);
 
+    if (status != LEPT_OK || bubbleMaskPixs == nullptr)
+    {
+        debugMsg("pixClipToForeground failed!");
+        pixDestroy(&grayPixs);
+        boxDestroy(&bubbleBox);
+        return nullptr;
+    }
+
+    PIX *bubbleGrayPixs = pixClipRectangle(grayPixs, bubbleBox, nullptr);
+    pixDestroy(&grayPixs);
+
+    if (bubbleGrayPixs == nullptr)
+    {
+        debugMsg("pixClipRectangle failed!");
+        pixDestroy(&bubbleMaskPixs);
+        boxDestroy(&bubbleBox);
+        return nullptr;
+    }
+
+    // Scale, Unsharp Mark, Binarize only the bubble
+    PIX *bubbleBinarizePixs = scaleUnsharpBinarize(bubbleGrayPixs);
+    pixDestroy(&bubbleGrayPixs);
+
+    if (bubbleBinarizePixs == nullptr)
+    {
+        pixDestroy(&bubbleMaskPixs);
+        boxDestroy(&bubbleBox);
+        return nullptr;
+    }
+
+    if (startPtIsBlack)
+    {
+        pixInvert(bubbleBinarizePixs, bubbleBinarizePixs);
+    }
+
+    // Scale the mask to exactly match the scaled bubble
+    PIX *scaledMaskPixs = pixScaleToSize(bubbleMaskPixs, bubbleBinarizePixs->w, bubbleBinarizePixs->h);
+    pixDestroy(&bubbleMaskPixs);
+
+    if (scaledMaskPixs == nullptr)
+    {
+        debugMsg("pixScaleToSize failed!");
+        pixDestroy(&bubbleBinarizePixs);
+        boxDestroy(&bubbleBox);
+        return nullptr;
+    }
+
+    // AND with the binarized bubble to remove everything except for the text
+    PIX *andPixs = pixAnd(nullptr, scaledMaskPixs, bubbleBinarizePixs);
+    pixDestroy(&bubbleBinarizePixs);
+    pixDestroy(&scaledMaskPixs);
+
+    // Offset of the bubble in the scaled coordinates of boundingRect
+    int bubbleOffsetX = (int)(bubbleBox->x * scaleFactor);
+    int bubbleOffsetY = (int)(bubbleBox->y * scaleFactor);
+    boxDestroy(&bubbleBox);
+
     if (andPixs == nullptr)
     {
         debugMsg("pixAnd failed!");
@@ -863,10 +1102,11 @@ PIX *PreProcess::extractBubbleText(PIX *pixs, int pt_x, int pt_y)
         return nullptr;
     }
 
-    boundingRect.x = foregroundBox->x;
-    boundingRect.y = foregroundBox->y;
+    boundingRect.x = bubbleOffsetX + foregroundBox->x;
+    boundingRect.y = bubbleOffsetY + foregroundBox->y;
     boundingRect.w = foregroundBox->w;
     boundingRect.h = foregroundBox->h;
+    boxDestroy(&foregroundBox);
 
     setDPI(borderPixs);
     return borderPixs;
@@ -21,14 +21,61 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 #define PRE_PROCESS_H
 
 #include <QImage>
+#include <QRect>
 
 #include "allheaders.h"
 #include "PreProcessCommon.h"
 
+// Settings for one call of the reentrant PreProcess API
+struct PreProcessOptions
+{
+    // Amount to scale input image to meet OCR engine minimum DPI requirements
+    float scaleFactor = 3.5f;
+
+    // Is the text vertical (affects furigana removal)
+    bool verticalText = false;
+
+    bool removeFurigana = false;
+
+    // Used by processImage() and processScaledImage()
+    bool deskew = false;
+    bool trim = false;
+};
+
+// Output of one call of the reentrant PreProcess API
+struct PreProcessResult
+{
+    // Pre-processed image, nullptr on failure.
+    // Be sure to call pixDestroy() on it to avoid memory leak.
+    PIX *pixs = nullptr;
+
+    // Scale factor that was applied (after clamping to the supported range)
+    float scaleFactor = 0.0f;
+
+    // Extracted text area in unscaled input coordinates.
+    // Set by extractTextBlock() and extractBubbleText().
+    QRect boundingRect;
+
+    // Number of lines detected during furigana removal
+    int numTextLines = 0;
+
+    // Time spent pre-processing
+    qint64 elapsedMs = 0;
+};
+
 class PreProcess
 {
 public:
     PreProcess();
+    explicit PreProcess(const PreProcessOptions &options);
+
+    // Reentrant API. These keep no state between calls, so any number of threads may
+    // pre-process at the same time. pixs is not modified.
+    static PreProcessResult processImage(PIX *pixs, const PreProcessOptions &options);
+    static PreProcessResult processScaledImage(PIX *pixGray, PIX *pixScaled, const PreProcessOptions &options);
+    static PreProcessResult extractTextBlock(PIX *pixs, int pt_x, int pt_y, int lookahead, int lookbehind,
+                                             int searchRadius, const PreProcessOptions &options);
+    static PreProcessResult extractBubbleText(PIX *pixs, int pt_x, int pt_y, const PreProcessOptions &options);
 
     bool getVerticalText() const;
     void setVerticalOrientation(bool value);
@@ -46,12 +93,15 @@ public:
     PIX *convertImageToPix(QString imageFile);
     PIX *convertImageToPix(QImage &image);
 
+    PIX *makeGray(PIX *pixs);
+    PIX *scaleUnsharp(PIX *pixs);
+
     PIX *processImage(PIX *pixs, bool performDeskew=false, bool trim=false);
+    PIX *processScaledImage(PIX *pixGray, PIX *pixScaled, bool performDeskew=false, bool trim=false);
     PIX *extractTextBlock(PIX *pixs, int pt_x, int pt_y, int lookahead, int lookbehind, int searchRadius);
     PIX *extractBubbleText(PIX *pixs, int pt_x, int pt_y);
 
 private:
-    PIX *makeGray(PIX *pixs);
     PIX *scale(PIX *pixs);
     PIX *unsharpMask(PIX *pixs);
     PIX *binarize(PIX *pixs);
@@ -60,8 +110,12 @@ private:
     PIX *addBorder(PIX *pixs);
     PIX *removeNoise(PIX *pixs);
     PIX *eraseFurigana(PIX *pixs);
+    bool isDarkBackground(PIX *pixGray);
+    PIX *finishProcessImage(PIX *pixBinarize, bool performDeskew, bool trim);
     void setDPI(PIX *pixs);
 
+    PreProcessResult makeResult(PIX *pixs, bool hasBoundingRect, qint64 elapsedMs) const;
+
     void debugMsg(QString str, bool error=true);
     void debugImg(QString filename, PIX *pixs);
 
@@ -0,0 +1,289 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDebug>
+#include <QMutexLocker>
+#include <QtMath>
+#include "PreviewTileCache.h"
+#include "UtilsImg.h"
+
+PreviewTileCache::PreviewTileCache()
+{
+
+}
+
+PreviewTileCache::~PreviewTileCache()
+{
+    clear();
+}
+
+void PreviewTileCache::clear()
+{
+    QMutexLocker locker(&mutex);
+
+    pixDestroy(&grayPixs);
+    grayRect = QRect();
+    clearTiles();
+}
+
+void PreviewTileCache::clearTiles()
+{
+    for(auto tile : tiles)
+    {
+        pixDestroy(&tile);
+    }
+
+    tiles.clear();
+}
+
+// Get the scaled and unsharp masked grayscale image of the screen area rect, ready for
+// PreProcess::processScaledImage(). Only the parts of rect that were not covered by the
+// previous call are grabbed from the screen (or cropped from frozenFrame if it is not null).
+// The unscaled grayscale image is returned in pixGray.
+// Be sure to call pixDestroy() on both returned PIX pointers to avoid memory leak.
+PIX *PreviewTileCache::capture(const QRect &rect, PreProcess &preProcess, PIX **pixGray,
+                               const QImage &frozenFrame)
+{
+    QMutexLocker locker(&mutex);
+
+    *pixGray = nullptr;
+
+    if(rect.isEmpty())
+    {
+        return nullptr;
+    }
+
+    if(preProcess.getScaleFactor() != tileScaleFactor)
+    {
+        clearTiles();
+        tileScaleFactor = preProcess.getScaleFactor();
+    }
+
+    // Compose the grayscale image from the overlap with the previous rect and the newly exposed strips
+    PIX *gray = pixCreate(rect.width(), rect.height(), 8);
+
+    if(gray == nullptr)
+    {
+        return nullptr;
+    }
+
+    QRect overlap;
+
+    if(grayPixs != nullptr)
+    {
+        overlap = rect.intersected(grayRect);
+    }
+
+    if(!overlap.isEmpty())
+    {
+        pixRasterop(gray, overlap.x() - rect.x(), overlap.y() - rect.y(), overlap.width(), overlap.height(),
+                    PIX_SRC, grayPixs, overlap.x() - grayRect.x(), overlap.y() - grayRect.y());
+    }
+
+    for(const QRect &strip : getExposedStrips(rect, overlap))
+    {
+        if(!grabStrip(gray, rect, strip, preProcess, frozenFrame))
+        {
+            pixDestroy(&gray);
+            return nullptr;
+        }
+    }
+
+    pixDestroy(&grayPixs);
+    grayPixs = gray;
+    grayRect = rect;
+
+    // Forget tiles whose surroundings are no longer fully inside the rect
+    for(auto it = tiles.begin(); it != tiles.end();)
+    {
+        QRect tileRect(it.key().first * tileSize, it.key().second * tileSize, tileSize, tileSize);
+
+        if(!rect.contains(tileRect.adjusted(-tileMargin, -tileMargin, tileMargin, tileMargin)))
+        {
+            pixDestroy(&it.value());
+            it = tiles.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // Assemble the scaled image from the tiles
+    int scaledLeft = toScaled(rect.x());
+    int scaledTop = toScaled(rect.y());
+    PIX *scaled = pixCreate(toScaled(rect.x() + rect.width()) - scaledLeft,
+                            toScaled(rect.y() + rect.height()) - scaledTop, 8);
+
+    if(scaled == nullptr)
+    {
+        return nullptr;
+    }
+
+    for(int row = floorDiv(rect.top(), tileSize); row <= floorDiv(rect.bottom(), tileSize); row++)
+    {
+        for(int col = floorDiv(rect.left(), tileSize); col <= floorDiv(rect.right(), tileSize); col++)
+        {
+            QRect tileRect(col * tileSize, row * tileSize, tileSize, tileSize);
+            bool keepTile = rect.contains(tileRect.adjusted(-tileMargin, -tileMargin, tileMargin, tileMargin));
+            PIX *tile = tiles.value(TileKey(col, row), nullptr);
+
+            if(tile == nullptr)
+            {
+                tile = scaleTile(gray, rect, tileRect, preProcess);
+
+                if(tile == nullptr)
+                {
+                    pixDestroy(&scaled);
+                    return nullptr;
+                }
+
+                if(keepTile)
+                {
+                    tiles.insert(TileKey(col, row), tile);
+                }
+            }
+
+            QRect visibleRect = tileRect.intersected(rect);
+            pixRasterop(scaled, toScaled(visibleRect.x()) - scaledLeft, toScaled(visibleRect.y()) - scaledTop,
+                        tile->w, tile->h, PIX_SRC, tile, 0, 0);
+
+            if(!keepTile)
+            {
+                pixDestroy(&tile);
+            }
+        }
+    }
+
+    *pixGray = pixCopy(nullptr, gray);
+
+    return scaled;
+}
+
+// Get the parts of rect that are not covered by overlap. overlap must be inside rect.
+QList<QRect> PreviewTileCache::getExposedStrips(const QRect &rect, const QRect &overlap)
+{
+    QList<QRect> strips;
+
+    if(overlap.isEmpty())
+    {
+        strips.append(rect);
+        return strips;
+    }
+
+    QRect top(rect.x(), rect.y(), rect.width(), overlap.y() - rect.y());
+    QRect bottom(rect.x(), overlap.bottom() + 1, rect.width(), rect.bottom() - overlap.bottom());
+    QRect left(rect.x(), overlap.y(), overlap.x() - rect.x(), overlap.height());
+    QRect right(overlap.right() + 1, overlap.y(), rect.right() - overlap.right(), overlap.height());
+
+    for(const QRect &strip : { top, bottom, left, right })
+    {
+        if(!strip.isEmpty())
+        {
+            strips.append(strip);
+        }
+    }
+
+    return strips;
+}
+
+// Grab a strip of the screen and copy it in grayscale into pixGray, which covers rect.
+bool PreviewTileCache::grabStrip(PIX *pixGray, const QRect &rect, const QRect &strip, PreProcess &preProcess,
+                                 const QImage &frozenFrame)
+{
+    QImage image = UtilsImg::takeScreenshot(strip, frozenFrame);
+
+    if(image.isNull())
+    {
+        return false;
+    }
+
+    PIX *stripPixs = preProcess.convertImageToPix(image);
+
+    if(stripPixs == nullptr)
+    {
+        return false;
+    }
+
+    PIX *stripGray = preProcess.makeGray(stripPixs);
+    pixDestroy(&stripPixs);
+
+    if(stripGray == nullptr)
+    {
+        return false;
+    }
+
+    pixRasterop(pixGray, strip.x() - rect.x(), strip.y() - rect.y(), strip.width(), strip.height(),
+                PIX_SRC, stripGray, 0, 0);
+    pixDestroy(&stripGray);
+
+    return true;
+}
+
+// Scale and unsharp mask the part of a tile that is inside rect. A margin of surrounding
+// pixels is included so that the result matches scaling the whole image.
+// Be sure to call pixDestroy() on the returned PIX pointer to avoid memory leak.
+PIX *PreviewTileCache::scaleTile(PIX *pixGray, const QRect &rect, const QRect &tileRect, PreProcess &preProcess)
+{
+    QRect visibleRect = tileRect.intersected(rect);
+    QRect patchRect = tileRect.adjusted(-tileMargin, -tileMargin, tileMargin, tileMargin).intersected(rect);
+
+    BOX patchBox;
+    patchBox.x = patchRect.x() - rect.x();
+    patchBox.y = patchRect.y() - rect.y();
+    patchBox.w = patchRect.width();
+    patchBox.h = patchRect.height();
+
+    PIX *patchPixs = pixClipRectangle(pixGray, &patchBox, nullptr);
+
+    if(patchPixs == nullptr)
+    {
+        return nullptr;
+    }
+
+    PIX *scaledPatch = preProcess.scaleUnsharp(patchPixs);
+    pixDestroy(&patchPixs);
+
+    if(scaledPatch == nullptr)
+    {
+        return nullptr;
+    }
+
+    BOX tileBox;
+    tileBox.x = toScaled(visibleRect.x()) - toScaled(patchRect.x());
+    tileBox.y = toScaled(visibleRect.y()) - toScaled(patchRect.y());
+    tileBox.w = toScaled(visibleRect.x() + visibleRect.width()) - toScaled(visibleRect.x());
+    tileBox.h = toScaled(visibleRect.y() + visibleRect.height()) - toScaled(visibleRect.y());
+
+    PIX *tile = pixClipRectangle(scaledPatch, &tileBox, nullptr);
+    pixDestroy(&scaledPatch);
+
+    return tile;
+}
+
+int PreviewTileCache::floorDiv(int value, int divisor)
+{
+    return (int)qFloor(value / (double)divisor);
+}
+
+// Convert a screen coordinate to a coordinate in the scaled image
+int PreviewTileCache::toScaled(int value) const
+{
+    return (int)qFloor(value * tileScaleFactor);
+}
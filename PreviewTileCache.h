@@ -0,0 +1,79 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PREVIEW_TILE_CACHE_H
+#define PREVIEW_TILE_CACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QRect>
+
+#include "allheaders.h"
+#include "PreProcess.h"
+
+// Keeps the screen pixels of the previous OCR preview so that consecutive previews
+// of an overlapping capture rect only have to grab and pre-process what is new.
+//
+// The grayscale screen contents of the last rect are kept as-is. The scaled and
+// unsharp masked version is kept as tiles on a grid aligned to screen coordinates.
+// Only tiles whose surroundings are fully inside the capture rect are kept, since
+// tiles at the edge of the rect change as the rect grows.
+class PreviewTileCache
+{
+public:
+    PreviewTileCache();
+    ~PreviewTileCache();
+
+    PIX *capture(const QRect &rect, PreProcess &preProcess, PIX **pixGray,
+                 const QImage &frozenFrame=QImage());
+    void clear();
+
+private:
+    typedef QPair<int, int> TileKey;
+
+    // Size of a tile in screen pixels
+    static const int tileSize = 64;
+
+    // Screen pixels around a tile that affect its scaled and unsharp masked contents
+    static const int tileMargin = 4;
+
+    static QList<QRect> getExposedStrips(const QRect &rect, const QRect &overlap);
+    static int floorDiv(int value, int divisor);
+    int toScaled(int value) const;
+
+    bool grabStrip(PIX *pixGray, const QRect &rect, const QRect &strip, PreProcess &preProcess,
+                   const QImage &frozenFrame);
+    PIX *scaleTile(PIX *pixGray, const QRect &rect, const QRect &tileRect, PreProcess &preProcess);
+    void clearTiles();
+
+    QMutex mutex;
+
+    // Grayscale screen contents of grayRect
+    PIX *grayPixs = nullptr;
+    QRect grayRect;
+
+    // Scaled and unsharp masked tiles, key is the tile column and row
+    QHash<TileKey, PIX *> tiles;
+    float tileScaleFactor = 0.0f;
+};
+
+#endif // PREVIEW_TILE_CACHE_H
@@ -0,0 +1,184 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QMutexLocker>
+#include "PixelKernels.h"
+#include "ScreenChangeDetector.h"
+#include "Settings.h"
+
+ScreenChangeDetector::ScreenChangeDetector()
+    : valid(false)
+{
+
+}
+
+// If the screen area, OCR settings and screen contents match the last capture,
+// put the last OCR result in result and return true.
+bool ScreenChangeDetector::getLastResult(const QRect &rect, const QString &settingsFingerprint,
+                                         const QImage &image, QString *result)
+{
+    return getLastResult(rect, settingsFingerprint, computeSignature(image), result);
+}
+
+bool ScreenChangeDetector::getLastResult(const QRect &rect, const QString &settingsFingerprint,
+                                         const Signature &signature, QString *result)
+{
+    QMutexLocker locker(&mutex);
+
+    if(!valid || rect != lastRect || settingsFingerprint != lastFingerprint)
+    {
+        return false;
+    }
+
+    if(!signaturesMatch(signature, lastSignature, Settings::getOcrUnchangedMaxTiles()))
+    {
+        return false;
+    }
+
+    *result = lastResult;
+
+    return true;
+}
+
+void ScreenChangeDetector::setLastResult(const QRect &rect, const QString &settingsFingerprint,
+                                         const QImage &image, const QString &result)
+{
+    setLastResult(rect, settingsFingerprint, computeSignature(image), result);
+}
+
+void ScreenChangeDetector::setLastResult(const QRect &rect, const QString &settingsFingerprint,
+                                         const Signature &signature, const QString &result)
+{
+    QMutexLocker locker(&mutex);
+
+    valid = true;
+    lastRect = rect;
+    lastFingerprint = settingsFingerprint;
+    lastSignature = signature;
+    lastResult = result;
+}
+
+void ScreenChangeDetector::clear()
+{
+    QMutexLocker locker(&mutex);
+
+    valid = false;
+    lastSignature.clear();
+    lastResult.clear();
+}
+
+// FNV-1a, 64 bit
+void ScreenChangeDetector::hashByte(quint64 &hash, quint8 value)
+{
+    hash = (hash ^ value) * Q_UINT64_C(0x100000001b3);
+}
+
+// Hash the grayscale pixels of each tileSize x tileSize tile of image, row by row.
+ScreenChangeDetector::Signature ScreenChangeDetector::computeSignature(const QImage &image)
+{
+    Signature signature;
+
+    if(image.isNull())
+    {
+        return signature;
+    }
+
+    QImage rgbImage = image.convertToFormat(QImage::Format_RGB32);
+    int width = rgbImage.width();
+    int height = rgbImage.height();
+    int tilesX = (width + tileSize - 1) / tileSize;
+    int tilesY = (height + tileSize - 1) / tileSize;
+
+    signature.fill(Q_UINT64_C(0xcbf29ce484222325), tilesX * tilesY);
+
+    for(int y = 0; y < height; y++)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb *>(rgbImage.constScanLine(y));
+        quint64 *row = signature.data() + (y / tileSize) * tilesX;
+
+        for(int x = 0; x < width; x++)
+        {
+            QRgb pixel = line[x];
+
+            // Same conversion as PreProcess::makeGray() so that signatures of screenshots
+            // and grayscale images of the same pixels are identical
+            hashByte(row[x / tileSize], (quint8)PixelKernels::grayValue(qRed(pixel), qGreen(pixel), qBlue(pixel)));
+        }
+    }
+
+    return signature;
+}
+
+// Same as computeSignature(const QImage &), for an 8 bpp grayscale image.
+ScreenChangeDetector::Signature ScreenChangeDetector::computeSignature(PIX *pixGray)
+{
+    Signature signature;
+
+    if(pixGray == nullptr || pixGray->d != 8)
+    {
+        return signature;
+    }
+
+    int width = pixGray->w;
+    int height = pixGray->h;
+    int tilesX = (width + tileSize - 1) / tileSize;
+    int tilesY = (height + tileSize - 1) / tileSize;
+    l_uint32 *data = pixGetData(pixGray);
+    int wpl = pixGetWpl(pixGray);
+
+    signature.fill(Q_UINT64_C(0xcbf29ce484222325), tilesX * tilesY);
+
+    for(int y = 0; y < height; y++)
+    {
+        l_uint32 *line = data + y * wpl;
+        quint64 *row = signature.data() + (y / tileSize) * tilesX;
+
+        for(int x = 0; x < width; x++)
+        {
+            hashByte(row[x / tileSize], GET_DATA_BYTE(line, x));
+        }
+    }
+
+    return signature;
+}
+
+bool ScreenChangeDetector::signaturesMatch(const Signature &sig1, const Signature &sig2, int maxChangedTiles)
+{
+    if(sig1.isEmpty() || sig1.size() != sig2.size())
+    {
+        return false;
+    }
+
+    int changedTiles = 0;
+
+    for(int i = 0; i < sig1.size(); i++)
+    {
+        if(sig1[i] != sig2[i])
+        {
+            changedTiles++;
+
+            if(changedTiles > maxChangedTiles)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,73 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCREEN_CHANGE_DETECTOR_H
+#define SCREEN_CHANGE_DETECTOR_H
+
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+#include "allheaders.h"
+
+// Remembers the OCR result of the last capture together with a coarse signature of the
+// screen pixels it was made from, so that capturing an unchanged screen area again
+// can return the previous result without pre-processing and OCR.
+//
+// The signature is a hash of the grayscale pixels of each tile of the image, the same
+// grayscale values that pre-processing starts from. Two signatures match when no more
+// than maxChangedTiles tiles differ. The default of 0 only matches identical pixels.
+class ScreenChangeDetector
+{
+public:
+    typedef QVector<quint64> Signature;
+
+    ScreenChangeDetector();
+
+    bool getLastResult(const QRect &rect, const QString &settingsFingerprint,
+                       const QImage &image, QString *result);
+    bool getLastResult(const QRect &rect, const QString &settingsFingerprint,
+                       const Signature &signature, QString *result);
+    void setLastResult(const QRect &rect, const QString &settingsFingerprint,
+                       const QImage &image, const QString &result);
+    void setLastResult(const QRect &rect, const QString &settingsFingerprint,
+                       const Signature &signature, const QString &result);
+    void clear();
+
+    static Signature computeSignature(const QImage &image);
+    static Signature computeSignature(PIX *pixGray);
+    static bool signaturesMatch(const Signature &sig1, const Signature &sig2, int maxChangedTiles);
+
+private:
+    // Size of a tile in screen pixels
+    static const int tileSize = 16;
+
+    static void hashByte(quint64 &hash, quint8 value);
+
+    QMutex mutex;
+    bool valid;
+    QRect lastRect;
+    QString lastFingerprint;
+    Signature lastSignature;
+    QString lastResult;
+};
+
+#endif // SCREEN_CHANGE_DETECTOR_H
@@ -44,21 +44,30 @@ const QString Settings::defaultOcrQuickAccessLang3("German");
 
 const QString Settings::defaultOcrTextOrientation("Auto");
 const QString Settings::defaultOcrTesseractConfigFile("");
+const QString Settings::defaultOcrEngineMode("Default");
+const QString Settings::defaultOcrModelTier("");
 const QString Settings::defaultOcrWhitelist("");
 const QString Settings::defaultOcrBlacklist("");
 const double Settings::defaultOcrScaleFactor(3.5);
 
 const QString Settings::defaultOutputLogFile("");
 const QString Settings::defaultOutputLogFormat("${capture}${linebreak}");
+const QString Settings::defaultOutputLogFlushPolicy("Flush");
 const QFont Settings::defaultOutputPopupFont("Arial", 12);
 const QString Settings::defaultOutputCallExe("");
 
 const QColor Settings::defaultPreviewBackgroundColor(10, 10, 10, 255);
 const QColor Settings::defaultPreviewBorderColor(128, 128, 128, 255);
 const QString Settings::defaultPreviewPosition("Fixed - Top Left");
+const QString Settings::defaultPreviewEngineMode("");
+const QString Settings::defaultPreviewModelTier("");
+const double Settings::defaultPreviewFastScaleFactor(1.5);
 const QColor Settings::defaultPreviewTextColor(200, 200, 200, 255);
 const QFont Settings::defaultPreviewTextFont("Arial", 16);
 
+const QString Settings::defaultTranslateBackend("Google");
+const QString Settings::defaultTranslateEndpoint("");
+
 QList<Replacement> Settings::getOcrReplacementList(QString lang)
 {
     static QList<Replacement> defaultJapaneseList = QList<Replacement>()
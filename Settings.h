@@ -41,6 +41,10 @@ public:
     static QColor getCaptureBoxBorderColor() { return QSettings().value("CaptureBox/BorderColor", defaultCaptureBoxBorderColor).value<QColor>(); }
     static void setCaptureBoxBorderColor( QColor value) { QSettings().setValue("CaptureBox/BorderColor", value); }
 
+    static const bool defaultCaptureBoxFrozenFrame = false;
+    static bool getCaptureBoxFrozenFrame() { return QSettings().value("CaptureBox/FrozenFrame", defaultCaptureBoxFrozenFrame).toBool(); }
+    static void setCaptureBoxFrozenFrame(bool value) { QSettings().setValue("CaptureBox/FrozenFrame", value); }
+
     static const bool defaultDebugPrependCoords = false;
     static bool getDebugPrependCoords() { return QSettings().value("Debug/PrependCoords", defaultDebugPrependCoords).toBool(); }
     static void setDebugPrependCoords(bool value) { QSettings().setValue("Debug/PrependCoords", value); }
@@ -153,6 +157,27 @@ public:
     static bool getOcrDeskew() { return QSettings().value("OCR/Deskew", defaultOcrDeskew).toBool(); }
     static void setOcrDeskew(bool value) { QSettings().setValue("OCR/Deskew", value); }
 
+    static const bool defaultOcrParallelLines = false;
+    static bool getOcrParallelLines() { return QSettings().value("OCR/ParallelLines", defaultOcrParallelLines).toBool(); }
+    static void setOcrParallelLines(bool value) { QSettings().setValue("OCR/ParallelLines", value); }
+
+    static const QString defaultOcrEngineMode;
+    static QString getOcrEngineMode() { return QSettings().value("OCR/EngineMode", defaultOcrEngineMode).toString(); }
+    static void setOcrEngineMode(QString value) { QSettings().setValue("OCR/EngineMode", value); }
+
+    static const QString defaultOcrModelTier;
+    static QString getOcrModelTier() { return QSettings().value("OCR/ModelTier", defaultOcrModelTier).toString(); }
+    static void setOcrModelTier(QString value) { QSettings().setValue("OCR/ModelTier", value); }
+
+    static const bool defaultOcrSkipUnchanged = false;
+    static bool getOcrSkipUnchanged() { return QSettings().value("OCR/SkipUnchanged", defaultOcrSkipUnchanged).toBool(); }
+    static void setOcrSkipUnchanged(bool value) { QSettings().setValue("OCR/SkipUnchanged", value); }
+
+    // Number of 16x16 tiles that may differ from the last capture, 0 to only skip identical screens
+    static const int defaultOcrUnchangedMaxTiles = 0;
+    static int getOcrUnchangedMaxTiles() { return QSettings().value("OCR/UnchangedMaxTiles", defaultOcrUnchangedMaxTiles).toInt(); }
+    static void setOcrUnchangedMaxTiles(int value) { QSettings().setValue("OCR/UnchangedMaxTiles", value); }
+
     static const int defaultTextLineCaptureLength = 1500;
     static int getTextLineCaptureLength() { return QSettings().value("TextLineCapture/Length", defaultTextLineCaptureLength).toInt(); }
     static void setTextLineCaptureLength(int value) { QSettings().setValue("TextLineCapture/Length", value); }
@@ -229,6 +254,11 @@ public:
     static QString getOutputLogFormat() { return QSettings().value("Output/LogFormat", defaultOutputLogFormat).toString(); }
     static void setOutputLogFormat(QString value) { QSettings().setValue("Output/LogFormat", value); }
 
+    // "None", "Flush" or "Sync". See OutputLogWriter::FlushPolicy.
+    static const QString defaultOutputLogFlushPolicy;
+    static QString getOutputLogFlushPolicy() { return QSettings().value("Output/LogFlushPolicy", defaultOutputLogFlushPolicy).toString(); }
+    static void setOutputLogFlushPolicy(QString value) { QSettings().setValue("Output/LogFlushPolicy", value); }
+
     static QSize getOutputPopupWindowSize() { return QSettings().value("Output/OutputPopupWindowSize", QSize(355, 165)).toSize(); }
     static void setOutputPopupWindowSize(QSize value) { QSettings().setValue("Output/OutputPopupWindowSize", value); }
 
@@ -248,6 +278,11 @@ public:
     static QString getOutputCallExe() { return QSettings().value("Output/CallExe", defaultOutputCallExe).toString(); }
     static void setOutputCallExe(QString value) { QSettings().setValue("Output/CallExe", value); }
 
+    // Start the executable once and send each capture to its stdin as a JSON line. See CallExeWorker.
+    static const bool defaultOutputCallExePersistent = false;
+    static bool getOutputCallExePersistent() { return QSettings().value("Output/CallExePersistent", defaultOutputCallExePersistent).toBool(); }
+    static void setOutputCallExePersistent(bool value) { QSettings().setValue("Output/CallExePersistent", value); }
+
     static bool getOutputPopupTopmost() { return QSettings().value("Output/PopupTopmost", true).toBool(); }
     static void setOutputPopupTopmost(bool value) { QSettings().setValue("Output/PopupTopmost", value); }
 
@@ -267,6 +302,42 @@ public:
     static QString getPreviewPosition() { return QSettings().value("Preview/Position", defaultPreviewPosition).toString(); }
     static void setPreviewPosition(QString value) { QSettings().setValue("Preview/Position", value); }
 
+    static const bool defaultPreviewIncremental = true;
+    static bool getPreviewIncremental() { return QSettings().value("Preview/Incremental", defaultPreviewIncremental).toBool(); }
+    static void setPreviewIncremental(bool value) { QSettings().setValue("Preview/Incremental", value); }
+
+    // Empty means same as OCR/EngineMode
+    static const QString defaultPreviewEngineMode;
+    static QString getPreviewEngineMode() { return QSettings().value("Preview/EngineMode", defaultPreviewEngineMode).toString(); }
+    static void setPreviewEngineMode(QString value) { QSettings().setValue("Preview/EngineMode", value); }
+
+    // Empty means same as OCR/ModelTier
+    static const QString defaultPreviewModelTier;
+    static QString getPreviewModelTier() { return QSettings().value("Preview/ModelTier", defaultPreviewModelTier).toString(); }
+    static void setPreviewModelTier(QString value) { QSettings().setValue("Preview/ModelTier", value); }
+
+    // Run previews on their own engine so that final captures and hotkey captures never wait for them
+    static const bool defaultPreviewDedicatedEngine = true;
+    static bool getPreviewDedicatedEngine() { return QSettings().value("Preview/DedicatedEngine", defaultPreviewDedicatedEngine).toBool(); }
+    static void setPreviewDedicatedEngine(bool value) { QSettings().setValue("Preview/DedicatedEngine", value); }
+
+    // Maximum number of engines that work on a preview when text lines are recognized in parallel
+    static const int defaultPreviewMaxEngines = 2;
+    static int getPreviewMaxEngines() { return QSettings().value("Preview/MaxEngines", defaultPreviewMaxEngines).toInt(); }
+    static void setPreviewMaxEngines(int value) { QSettings().setValue("Preview/MaxEngines", value); }
+
+    static const bool defaultPreviewProgressive = false;
+    static bool getPreviewProgressive() { return QSettings().value("Preview/Progressive", defaultPreviewProgressive).toBool(); }
+    static void setPreviewProgressive(bool value) { QSettings().setValue("Preview/Progressive", value); }
+
+    static const double defaultPreviewFastScaleFactor;
+    static double getPreviewFastScaleFactor() { return QSettings().value("Preview/FastScaleFactor", defaultPreviewFastScaleFactor).toDouble(); }
+    static void setPreviewFastScaleFactor(double value) { QSettings().setValue("Preview/FastScaleFactor", value); }
+
+    static const bool defaultPreviewReuseResult = true;
+    static bool getPreviewReuseResult() { return QSettings().value("Preview/ReuseResult", defaultPreviewReuseResult).toBool(); }
+    static void setPreviewReuseResult(bool value) { QSettings().setValue("Preview/ReuseResult", value); }
+
     static const QColor defaultPreviewTextColor;
     static QColor getPreviewTextColor() { return QSettings().value("Preview/TextColor", defaultPreviewTextColor).value<QColor>(); }
     static void setPreviewTextColor( QColor value) { QSettings().setValue("Preview/TextColor", value); }
@@ -297,6 +368,31 @@ public:
     static int getTranslateServerTimeout() { return QSettings().value("Translate/ServerTimeout", defaultTranslateServerTimeout).toInt(); }
     static void setTranslateServerTimeout(int value) { QSettings().setValue("Translate/ServerTimeout", value); }
 
+    // Number of translations kept in the cache, 0 to disable the cache
+    static const int defaultTranslateCacheSize = 1000;
+    static int getTranslateCacheSize() { return QSettings().value("Translate/CacheSize", defaultTranslateCacheSize).toInt(); }
+    static void setTranslateCacheSize(int value) { QSettings().setValue("Translate/CacheSize", value); }
+
+    // Keep the cache in a file next to the settings file between sessions
+    static const bool defaultTranslateCachePersist = true;
+    static bool getTranslateCachePersist() { return QSettings().value("Translate/CachePersist", defaultTranslateCachePersist).toBool(); }
+    static void setTranslateCachePersist(bool value) { QSettings().setValue("Translate/CachePersist", value); }
+
+    // "Google" or "JsonPost". See TranslateBackend::create().
+    static const QString defaultTranslateBackend;
+    static QString getTranslateBackend() { return QSettings().value("Translate/Backend", defaultTranslateBackend).toString(); }
+    static void setTranslateBackend(QString value) { QSettings().setValue("Translate/Backend", value); }
+
+    // URL of the translation service, empty to use the default of the backend
+    static const QString defaultTranslateEndpoint;
+    static QString getTranslateEndpoint() { return QSettings().value("Translate/Endpoint", defaultTranslateEndpoint).toString(); }
+    static void setTranslateEndpoint(QString value) { QSettings().setValue("Translate/Endpoint", value); }
+
+    // Connect to the translation service when a capture starts
+    static const bool defaultTranslatePrewarm = true;
+    static bool getTranslatePrewarm() { return QSettings().value("Translate/Prewarm", defaultTranslatePrewarm).toBool(); }
+    static void setTranslatePrewarm(bool value) { QSettings().setValue("Translate/Prewarm", value); }
+
     static const bool defaultSpeechEnable = false;
     static bool getSpeechEnable() { return QSettings().value("Speech/Enable", defaultSpeechEnable).toBool(); }
     static void setSpeechEnable(bool value) { QSettings().setValue("Speech/Enable", value); }
@@ -0,0 +1,114 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QMutexLocker>
+#include <QThread>
+#include "OcrEngine.h"
+#include "TessdataIndex.h"
+
+TessdataIndex::TessdataIndex()
+    : valid(false),
+      watching(false),
+      watcher(nullptr)
+{
+#ifndef CLI_BUILD
+    // The watcher needs an event loop, so it lives in the main thread no matter
+    // which thread first used the index
+    QCoreApplication *app = QCoreApplication::instance();
+
+    if(app != nullptr)
+    {
+        if(QThread::currentThread() == app->thread())
+        {
+            // Watch right away so that lookups during startup are already cached
+            startWatching();
+        }
+        else
+        {
+            moveToThread(app->thread());
+            QMetaObject::invokeMethod(this, "startWatching", Qt::QueuedConnection);
+        }
+    }
+#endif
+}
+
+void TessdataIndex::startWatching()
+{
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &TessdataIndex::directoryChanged);
+
+    QMutexLocker locker(&mutex);
+
+    // If the directory does not exist yet, it cannot be watched and is scanned on every lookup
+    watching = watcher->addPath(OcrEngine::getTessdataPath());
+    valid = false;
+}
+
+void TessdataIndex::directoryChanged()
+{
+    QMutexLocker locker(&mutex);
+    valid = false;
+}
+
+bool TessdataIndex::containsLangCode(const QString &langCode)
+{
+    QMutexLocker locker(&mutex);
+    update();
+
+    return langCodes.contains(langCode);
+}
+
+QStringList TessdataIndex::getLangCodes()
+{
+    QMutexLocker locker(&mutex);
+    update();
+
+    return langCodes.values();
+}
+
+// Scan the tessdata directory if the index is out of date. Caller must hold the mutex.
+void TessdataIndex::update()
+{
+    if(valid)
+    {
+        return;
+    }
+
+    QDir dir(OcrEngine::getTessdataPath());
+    QStringList nameFilter("*.traineddata");
+    QStringList langFiles = dir.entryList(nameFilter);
+
+    langCodes.clear();
+
+    foreach (const QString &file, langFiles)
+    {
+        QString langCode = file;
+        langCode.replace(".traineddata", "");
+        langCodes.insert(langCode);
+    }
+
+#ifdef CLI_BUILD
+    // The CLI is a one-shot process, the directory does not need to be watched
+    valid = true;
+#else
+    valid = watching;
+#endif
+}
@@ -0,0 +1,63 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TESSDATA_INDEX_H
+#define TESSDATA_INDEX_H
+
+#include <QFileSystemWatcher>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+// Process-wide index of the language codes that have a .traineddata file in the
+// tessdata directory. The directory is scanned once and scanned again only after a
+// QFileSystemWatcher reports that it changed, so lookups do not touch the filesystem.
+// The CLI scans the directory once and does not watch it.
+// Safe to use from any thread.
+class TessdataIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static TessdataIndex &getInstance()
+    {
+        static TessdataIndex instance;
+        return instance;
+    }
+
+    bool containsLangCode(const QString &langCode);
+    QStringList getLangCodes();
+
+private slots:
+    void startWatching();
+    void directoryChanged();
+
+private:
+    TessdataIndex();
+
+    void update();
+
+    QMutex mutex;
+    QSet<QString> langCodes;
+    bool valid;
+    bool watching;
+    QFileSystemWatcher *watcher;
+};
+
+#endif // TESSDATA_INDEX_H
@@ -22,78 +22,130 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 #include <QThread>
 #include <QDebug>
 #include <QCoreApplication>
-#include <QJsonDocument>
-#include <QJsonArray>
-#include <QJsonValue>
 #include "Translate.h"
 #include "ReplyTimeout.h"
 
 Translate::Translate()
+    : backend(new GoogleTranslateBackend())
 {
     connect(&manager, &QNetworkAccessManager::finished, this, &Translate::requestFinished);
 }
 
-void Translate::requestFinished(QNetworkReply *reply)
+Translate::~Translate()
 {
-    QString origPhrase = "";
-    QString replyUrlStr = reply->request().url().toString();
+    if(!cacheFile.isEmpty() && cache.isModified())
+    {
+        cache.save(cacheFile);
+    }
+}
 
-    if(requestMap.contains(replyUrlStr))
+// Take ownership of the backend used for new requests.
+// Replies already in flight are still parsed with the backend that made the request.
+void Translate::setBackend(TranslateBackend *newBackend)
+{
+    if(newBackend == nullptr || newBackend == backend.data())
     {
-        origPhrase = requestMap[replyUrlStr];
-        requestMap.remove(replyUrlStr);
+        return;
     }
 
-    if(!reply->isOpen())
+    backend.reset(newBackend);
+    prewarmTimer.invalidate();
+}
+
+// Open a connection to the translation server ahead of time so that the first
+// translation after a capture does not pay for DNS lookup and connection setup.
+void Translate::prewarmConnection()
+{
+    if(prewarmTimer.isValid() && prewarmTimer.elapsed() < prewarmIntervalMs)
     {
-        qDebug() << "Translation timeout occured!";
-        emit translationComplete(origPhrase, "", true);
+        return;
+    }
 
-        reply->deleteLater();
+    prewarmTimer.start();
+
+    QUrl url = backend->getEndpoint();
+
+    if(url.host().isEmpty())
+    {
         return;
     }
 
-    QString translationResponse(reply->readAll());
-    reply->close();
+#ifndef QT_NO_SSL
+    if(url.scheme() == "https")
+    {
+        manager.connectToHostEncrypted(url.host(), url.port(443));
+        return;
+    }
+#endif
 
-    reply->deleteLater();
+    manager.connectToHost(url.host(), url.port(80));
+}
+
+void Translate::setCacheCapacity(int capacity)
+{
+    cache.setCapacity(capacity);
+}
+
+// Load the translation cache from file and save it there on destruction.
+// Pass an empty string to keep the cache in memory only.
+void Translate::setCacheFile(QString file)
+{
+    if(file == cacheFile)
+    {
+        return;
+    }
 
-    // Example single-line response (input was "Cat Dog Horse"):
-    // [[[\"Katze Hund Pferd\",\"Cat Dog Horse\",null,null,3,null,null,null,[[[\"8fd9cdd8f4db2bd633174a12abc58066\",\"en_de_transformer_2019q2.md\"]]]]],null,\"en\"]
+    if(!cacheFile.isEmpty() && cache.isModified())
+    {
+        cache.save(cacheFile);
+    }
 
-    // Example multi-line response (input was "Cat\nDog\nHorse"):
-    // [[["Katze\n","Cat\n",null,null,2],["Hund\n","Dog\n",null,null,1],["Pferd","Horse",null,null,1]],null,"en"]
+    cacheFile = file;
 
-    QString translation;
+    if(!cacheFile.isEmpty())
+    {
+        cache.load(cacheFile);
+    }
+}
 
-    QJsonDocument jsonDoc = QJsonDocument::fromJson(translationResponse.toUtf8());
-    QJsonArray jsonArray1 = jsonDoc.array();
+void Translate::requestFinished(QNetworkReply *reply)
+{
+    PendingRequest origRequest = requestMap.take(reply);
+    inFlight.remove(origRequest.key);
 
-    if(jsonArray1.size() > 0)
+    if(!reply->isOpen())
     {
-        QJsonValue jsonValue1 = jsonArray1[0];
-        QJsonArray jsonArray2 = jsonValue1.toArray();
+        qDebug() << "Translation timeout occured!";
 
-        foreach (const QJsonValue & jsonValue2, jsonArray2)
+        for(const QString &origPhrase : origRequest.phrases)
         {
-            QJsonArray jsonArray3 = jsonValue2.toArray();
-
-            if(jsonArray3.size() > 0)
-            {
-                QJsonValue jsonTranslation = jsonArray3[0];
-                translation += jsonTranslation.toString();
-            }
+            emit translationComplete(origPhrase, "", true);
         }
+
+        reply->deleteLater();
+        return;
     }
 
-    translation = translation.replace("\\n", "\n");
+    QString translation = origRequest.backend->parseReply(reply->readAll());
+    reply->close();
+
+    reply->deleteLater();
+
+    if(!translation.isEmpty() && !origRequest.phrases.isEmpty())
+    {
+        cache.insert(origRequest.service, origRequest.langCodeFrom, origRequest.langCodeTo, origRequest.phrases.first(),
+                     translation);
+    }
 
     //qDebug() << "Translation: " << translation;
-    emit translationComplete(origPhrase, translation, false);
+
+    for(const QString &origPhrase : origRequest.phrases)
+    {
+        emit translationComplete(origPhrase, translation, false);
+    }
 }
 
 
-// https://stackoverflow.com/questions/8550147/how-to-use-google-translate-api-with-c/18813418#18813418
 bool Translate::startTranslate(QString phrase, QString from, QString to, int timeoutMillisec=2000)
 {
     QString langCodeFrom;
@@ -117,20 +169,30 @@ bool Translate::startTranslate(QString phrase, QString from, QString to, int tim
         return false;
     }
 
-    // Example request:
-    //   http://translate.googleapis.com/translate_a/single?client=gtx&sl=auto&tl=ja&dt=t&q=hello
-    // Answer:
-    //   [[["こんにちは","hello",,,1]],,"en",,,,1,,[["en"],,[1],["en"]]]
+    // Repeated phrases are answered from the cache without a request
+    QString service = backend->getServiceId();
+    QString cachedTranslation;
 
-    QString url = QString("http://translate.googleapis.com/translate_a/single?client=gtx&sl=%1&tl=%2&dt=t&q=%3")
-            .arg(langCodeFrom, langCodeTo, phrase);
+    if(cache.lookup(service, langCodeFrom, langCodeTo, phrase, &cachedTranslation))
+    {
+        emit translationComplete(phrase, cachedTranslation, false);
+        return true;
+    }
 
-    // For debug, here is a URL that will timeout
-    //QString url = QString("http://wiki.forum.nokia.com/index.php/How_to_wait_synchronously_for_a_Signal_in_Qt");
+    // If the same phrase is already being translated, wait for that reply instead
+    QString key = TranslationCache::makeKey(service, langCodeFrom, langCodeTo, phrase);
+
+    if(inFlight.contains(key))
+    {
+        requestMap[inFlight[key]].phrases.append(phrase);
+        return true;
+    }
 
-    QNetworkRequest request(url);
-    QNetworkReply *reply = manager.get(request);
-    requestMap.insert(reply->request().url().toString(), phrase);
+    QByteArray body;
+    QNetworkRequest request = backend->createRequest(phrase, langCodeFrom, langCodeTo, &body);
+    QNetworkReply *reply = body.isEmpty() ? manager.get(request) : manager.post(request, body);
+    requestMap.insert(reply, { backend, key, service, langCodeFrom, langCodeTo, QStringList(phrase) });
+    inFlight.insert(key, reply);
     ReplyTimeout::set(reply, timeoutMillisec);
     //qDebug() << "Starting translation...";
 
@@ -25,13 +25,24 @@ along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
 #include <QObject>
 #include <QString>
 #include <QMap>
+#include <QHash>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QSharedPointer>
+#include "TranslateBackend.h"
+#include "TranslationCache.h"
 
 class Translate : public QObject
 {
     Q_OBJECT
 public:
     Translate();
+    ~Translate();
     bool startTranslate(QString keyword, QString from, QString to, int timeoutMillisec);
+    void setBackend(TranslateBackend *newBackend);
+    void prewarmConnection();
+    void setCacheCapacity(int capacity);
+    void setCacheFile(QString file);
     static QStringList getAvailableLangs();
     static bool isValidLang(QString lang);
 
@@ -42,9 +53,31 @@ private:
     static QMap<QString, QString> populateLangMap();
     void requestFinished(QNetworkReply *data);
 
+    // A request in flight and every phrase waiting on it. Phrases that only differ in
+    // whitespace share the same request. The reply is parsed by the backend that made
+    // the request, even if another backend was set since.
+    struct PendingRequest
+    {
+        QSharedPointer<TranslateBackend> backend;
+        QString key;
+        QString service;
+        QString langCodeFrom;
+        QString langCodeTo;
+        QStringList phrases;
+    };
+
     static const QMap<QString, QString> mapLang; // Key = Lang name, Value = Two-letter code
     QNetworkAccessManager manager;
-    QMap<QString, QString> requestMap; // Key = URL, Value = phrase.
+    QSharedPointer<TranslateBackend> backend;
+
+    // Connections are kept alive by QNetworkAccessManager for a while, there is no
+    // need to open a new one on every capture
+    static const int prewarmIntervalMs = 30000;
+    QElapsedTimer prewarmTimer;
+    QMap<QNetworkReply *, PendingRequest> requestMap;
+    QHash<QString, QNetworkReply *> inFlight; // Key = TranslationCache::makeKey()
+    TranslationCache cache;
+    QString cacheFile; // Empty if the cache is not persisted
 };
 
 #endif // TRANSLATE_H
@@ -0,0 +1,121 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QUrlQuery>
+#include "TranslateBackend.h"
+
+const QString GoogleTranslateBackend::defaultEndpoint("http://translate.googleapis.com/translate_a/single");
+const QString JsonPostTranslateBackend::defaultEndpoint("http://localhost:5000/translate");
+
+TranslateBackend *TranslateBackend::create(QString name, QString endpoint)
+{
+    if(name.compare("Google", Qt::CaseInsensitive) == 0)
+    {
+        return endpoint.isEmpty() ? new GoogleTranslateBackend() : new GoogleTranslateBackend(QUrl(endpoint));
+    }
+    else if(name.compare("JsonPost", Qt::CaseInsensitive) == 0)
+    {
+        return endpoint.isEmpty() ? new JsonPostTranslateBackend() : new JsonPostTranslateBackend(QUrl(endpoint));
+    }
+
+    return nullptr;
+}
+
+// https://stackoverflow.com/questions/8550147/how-to-use-google-translate-api-with-c/18813418#18813418
+QNetworkRequest GoogleTranslateBackend::createRequest(const QString &phrase, const QString &from, const QString &to, QByteArray *body)
+{
+    // Example request:
+    //   http://translate.googleapis.com/translate_a/single?client=gtx&sl=auto&tl=ja&dt=t&q=hello
+    // Answer:
+    //   [[["こんにちは","hello",,,1]],,"en",,,,1,,[["en"],,[1],["en"]]]
+
+    QUrlQuery query;
+    query.addQueryItem("client", "gtx");
+    query.addQueryItem("sl", from);
+    query.addQueryItem("tl", to);
+    query.addQueryItem("dt", "t");
+    // QUrlQuery leaves '+' as is, which the server would read as a space
+    query.addQueryItem("q", QString(phrase).replace('+', "%2B"));
+
+    QUrl url = endpoint;
+    url.setQuery(query);
+
+    body->clear();
+
+    return QNetworkRequest(url);
+}
+
+QString GoogleTranslateBackend::parseReply(const QByteArray &data)
+{
+    // Example single-line response (input was "Cat Dog Horse"):
+    // [[[\"Katze Hund Pferd\",\"Cat Dog Horse\",null,null,3,null,null,null,[[[\"8fd9cdd8f4db2bd633174a12abc58066\",\"en_de_transformer_2019q2.md\"]]]]],null,\"en\"]
+
+    // Example multi-line response (input was "Cat\nDog\nHorse"):
+    // [[["Katze\n","Cat\n",null,null,2],["Hund\n","Dog\n",null,null,1],["Pferd","Horse",null,null,1]],null,"en"]
+
+    QString translation;
+
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data);
+    QJsonArray jsonArray1 = jsonDoc.array();
+
+    if(jsonArray1.size() > 0)
+    {
+        QJsonValue jsonValue1 = jsonArray1[0];
+        QJsonArray jsonArray2 = jsonValue1.toArray();
+
+        foreach (const QJsonValue & jsonValue2, jsonArray2)
+        {
+            QJsonArray jsonArray3 = jsonValue2.toArray();
+
+            if(jsonArray3.size() > 0)
+            {
+                QJsonValue jsonTranslation = jsonArray3[0];
+                translation += jsonTranslation.toString();
+            }
+        }
+    }
+
+    return translation.replace("\\n", "\n");
+}
+
+QNetworkRequest JsonPostTranslateBackend::createRequest(const QString &phrase, const QString &from, const QString &to, QByteArray *body)
+{
+    QJsonObject json;
+    json.insert("q", phrase);
+    json.insert("source", from);
+    json.insert("target", to);
+    json.insert("format", "text");
+
+    *body = QJsonDocument(json).toJson(QJsonDocument::Compact);
+
+    QNetworkRequest request(endpoint);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    return request;
+}
+
+QString JsonPostTranslateBackend::parseReply(const QByteArray &data)
+{
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(data);
+    return jsonDoc.object().value("translatedText").toString();
+}
@@ -0,0 +1,92 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRANSLATE_BACKEND_H
+#define TRANSLATE_BACKEND_H
+
+#include <QtNetwork/QNetworkRequest>
+#include <QByteArray>
+#include <QString>
+#include <QUrl>
+
+// Builds translation requests for a particular service and parses its replies.
+// Translate owns the network access, the backend only knows the wire format.
+class TranslateBackend
+{
+public:
+    explicit TranslateBackend(QUrl endpoint) : endpoint(endpoint) {}
+    virtual ~TranslateBackend() {}
+
+    QUrl getEndpoint() const { return endpoint; }
+
+    // Name as accepted by create()
+    virtual QString getName() const = 0;
+
+    // Identifies the service that translations come from, so that translations of
+    // different services or endpoints are not mixed up
+    QString getServiceId() const { return getName() + " " + endpoint.toString(); }
+
+    // Build the request for the given phrase. If body is set to a non-empty value the
+    // request is sent as a POST, otherwise as a GET.
+    virtual QNetworkRequest createRequest(const QString &phrase, const QString &from, const QString &to, QByteArray *body) = 0;
+
+    // Return the translation contained in the reply, or an empty string if there is none
+    virtual QString parseReply(const QByteArray &data) = 0;
+
+    // Create a backend by name ("Google" or "JsonPost"). If endpoint is empty, the default
+    // endpoint of the backend is used. Returns nullptr for an unknown name.
+    // Be sure to delete the returned backend when done with it.
+    static TranslateBackend *create(QString name, QString endpoint);
+
+protected:
+    QUrl endpoint;
+};
+
+// The unofficial Google Translate endpoint used by the web client:
+//   GET <endpoint>?client=gtx&sl=<from>&tl=<to>&dt=t&q=<phrase>
+class GoogleTranslateBackend : public TranslateBackend
+{
+public:
+    static const QString defaultEndpoint;
+
+    explicit GoogleTranslateBackend(QUrl endpoint=QUrl(defaultEndpoint)) : TranslateBackend(endpoint) {}
+
+    QString getName() const override { return "Google"; }
+
+    QNetworkRequest createRequest(const QString &phrase, const QString &from, const QString &to, QByteArray *body) override;
+    QString parseReply(const QByteArray &data) override;
+};
+
+// A simple JSON format as used by LibreTranslate and easy to implement in-house:
+//   POST <endpoint> {"q": <phrase>, "source": <from>, "target": <to>, "format": "text"}
+//   Reply: {"translatedText": <translation>}
+class JsonPostTranslateBackend : public TranslateBackend
+{
+public:
+    static const QString defaultEndpoint;
+
+    explicit JsonPostTranslateBackend(QUrl endpoint=QUrl(defaultEndpoint)) : TranslateBackend(endpoint) {}
+
+    QString getName() const override { return "JsonPost"; }
+
+    QNetworkRequest createRequest(const QString &phrase, const QString &from, const QString &to, QByteArray *body) override;
+    QString parseReply(const QByteArray &data) override;
+};
+
+#endif // TRANSLATE_BACKEND_H
@@ -0,0 +1,199 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QStringList>
+#include "TranslationCache.h"
+
+TranslationCache::TranslationCache(int capacity)
+    : capacity(qMax(capacity, 0)),
+      modified(false)
+{
+
+}
+
+bool TranslationCache::lookup(const QString &service, const QString &from, const QString &to, const QString &phrase,
+                              QString *translation)
+{
+    auto it = index.find(makeKey(service, from, to, phrase));
+
+    if(it == index.end())
+    {
+        return false;
+    }
+
+    // Move to the front, iterators of std::list stay valid when splicing
+    entries.splice(entries.begin(), entries, it.value());
+    *translation = it.value()->translation;
+    return true;
+}
+
+void TranslationCache::insert(const QString &service, const QString &from, const QString &to, const QString &phrase,
+                              const QString &translation)
+{
+    insertKey(makeKey(service, from, to, phrase), translation);
+    modified = true;
+}
+
+void TranslationCache::insertKey(const QString &key, const QString &translation)
+{
+    if(capacity == 0)
+    {
+        return;
+    }
+
+    auto it = index.find(key);
+
+    if(it != index.end())
+    {
+        it.value()->translation = translation;
+        entries.splice(entries.begin(), entries, it.value());
+        return;
+    }
+
+    entries.push_front({ key, translation });
+    index.insert(key, entries.begin());
+    evict();
+}
+
+void TranslationCache::clear()
+{
+    entries.clear();
+    index.clear();
+    modified = true;
+}
+
+void TranslationCache::setCapacity(int value)
+{
+    capacity = qMax(value, 0);
+    evict();
+}
+
+// Drop the least recently used entries beyond the capacity.
+void TranslationCache::evict()
+{
+    while((int)entries.size() > capacity)
+    {
+        index.remove(entries.back().key);
+        entries.pop_back();
+        modified = true;
+    }
+}
+
+// Captures of the same text can differ in surrounding whitespace, line ending style and
+// runs of spaces. Those differences do not change the translation.
+QString TranslationCache::normalizePhrase(const QString &phrase)
+{
+    QStringList lines = QString(phrase).replace("\r\n", "\n").split('\n');
+
+    for(QString &line : lines)
+    {
+        line = line.simplified();
+    }
+
+    return lines.join('\n').trimmed();
+}
+
+QString TranslationCache::makeKey(const QString &service, const QString &from, const QString &to, const QString &phrase)
+{
+    return service + QChar(0x1f) + from + QChar(0x1f) + to + QChar(0x1f) + normalizePhrase(phrase);
+}
+
+bool TranslationCache::load(const QString &file)
+{
+    QFile theFile(file);
+
+    if(!theFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QByteArray data = qUncompress(theFile.readAll());
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 count = 0;
+    stream >> magic >> version >> count;
+
+    if(stream.status() != QDataStream::Ok || magic != fileMagic || version != fileVersion)
+    {
+        return false;
+    }
+
+    entries.clear();
+    index.clear();
+
+    // Entries are stored most recently used first, so insert them in reverse
+    QList<Entry> loaded;
+
+    for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        Entry entry;
+        stream >> entry.key >> entry.translation;
+        loaded.append(entry);
+    }
+
+    if(stream.status() != QDataStream::Ok)
+    {
+        return false;
+    }
+
+    for(int i = loaded.size() - 1; i >= 0; i--)
+    {
+        insertKey(loaded[i].key, loaded[i].translation);
+    }
+
+    modified = false;
+    return true;
+}
+
+bool TranslationCache::save(const QString &file)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << fileMagic << fileVersion << (quint32)entries.size();
+
+    for(const Entry &entry : entries)
+    {
+        stream << entry.key << entry.translation;
+    }
+
+    // Write to a temporary file first so that a crash can not leave a truncated cache
+    QSaveFile theFile(file);
+
+    if(!theFile.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    theFile.write(qCompress(data));
+
+    if(!theFile.commit())
+    {
+        return false;
+    }
+
+    modified = false;
+    return true;
+}
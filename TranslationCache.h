@@ -0,0 +1,72 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRANSLATION_CACHE_H
+#define TRANSLATION_CACHE_H
+
+#include <QHash>
+#include <QString>
+#include <list>
+
+// Least recently used cache of translations keyed by service, language pair and phrase. The cache
+// can be saved to and loaded from a small compressed file so that it survives restarts.
+class TranslationCache
+{
+public:
+    explicit TranslationCache(int capacity=1000);
+
+    bool lookup(const QString &service, const QString &from, const QString &to, const QString &phrase, QString *translation);
+    void insert(const QString &service, const QString &from, const QString &to, const QString &phrase,
+                const QString &translation);
+    void clear();
+
+    int getCapacity() const { return capacity; }
+    void setCapacity(int value);
+
+    bool isModified() const { return modified; }
+
+    bool load(const QString &file);
+    bool save(const QString &file);
+
+    static QString normalizePhrase(const QString &phrase);
+    static QString makeKey(const QString &service, const QString &from, const QString &to, const QString &phrase);
+
+private:
+    struct Entry
+    {
+        QString key;
+        QString translation;
+    };
+
+    void insertKey(const QString &key, const QString &translation);
+    void evict();
+
+    // File format identification
+    static const quint32 fileMagic = 0x43325454; // "C2TT"
+    static const quint32 fileVersion = 2; // Version 1 keys lacked the service
+
+    int capacity;
+    bool modified;
+
+    // Most recently used first
+    std::list<Entry> entries;
+    QHash<QString, std::list<Entry>::iterator> index;
+};
+
+#endif // TRANSLATION_CACHE_H
@@ -37,6 +37,53 @@ QImage UtilsImg::takeScreenshot(const QRect &rect)
     return capturePixmap.toImage();
 }
 
+// Get the contents of the screen area rect. If frozenFrame is not null, rect is cropped
+// from it instead of grabbing the screen. The offset of frozenFrame is its position
+// on the virtual desktop (see takeVirtualDesktopScreenshot()).
+//
+// rect is in logical (device independent) pixels while frozenFrame holds physical pixels,
+// so on HiDPI screens rect is scaled by the device pixel ratio of frozenFrame, the same
+// way grabWindow() scales it. Like grabWindow() with a rect spanning several screens,
+// this assumes a single device pixel ratio for the whole virtual desktop.
+QImage UtilsImg::takeScreenshot(const QRect &rect, const QImage &frozenFrame)
+{
+    if(frozenFrame.isNull())
+    {
+        return takeScreenshot(rect);
+    }
+
+    QRect frameRect = rect.translated(-frozenFrame.offset());
+    qreal ratio = frozenFrame.devicePixelRatio();
+
+    if(ratio != 1.0)
+    {
+        frameRect = QRect(qRound(frameRect.x() * ratio), qRound(frameRect.y() * ratio),
+                          qRound(frameRect.width() * ratio), qRound(frameRect.height() * ratio));
+    }
+
+    QImage image = frozenFrame.copy(frameRect);
+    image.setDevicePixelRatio(ratio);
+
+    return image;
+}
+
+// Grab all screens at once. The offset of the returned image is set to the
+// top-left of the virtual desktop.
+QImage UtilsImg::takeVirtualDesktopScreenshot()
+{
+    QScreen *screen = QGuiApplication::primaryScreen();
+    if (!screen)
+    {
+        return QImage();
+    }
+
+    QRect virtualRect = screen->virtualGeometry();
+    QImage image = takeScreenshot(virtualRect);
+    image.setOffset(virtualRect.topLeft());
+
+    return image;
+}
+
 QString UtilsImg::getDebugScreenshotPath(QString filename, bool useTimestamp, QDateTime timestamp)
 {
     if(useTimestamp)
@@ -27,6 +27,8 @@ class UtilsImg
 {
 public:
     static QImage takeScreenshot(const QRect &rect);
+    static QImage takeScreenshot(const QRect &rect, const QImage &frozenFrame);
+    static QImage takeVirtualDesktopScreenshot();
     static QString getDebugScreenshotPath(QString filename, bool useTimestamp, QDateTime timestamp);
 private:
      UtilsImg() {}
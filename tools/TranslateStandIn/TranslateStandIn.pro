@@ -0,0 +1,14 @@
+QT += core network
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = TranslateStandIn
+
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,296 @@
+/*
+Copyright (C) 2010-2017 Christopher Brochtrup
+
+This file is part of Capture2Text.
+
+Capture2Text is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Capture2Text is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Capture2Text.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Local stand-in for the translation services supported by TranslateBackend.
+// It answers instantly (or after a configurable delay) with a fake translation so that
+// translation latency can be measured without a network connection.
+//
+//   GET  /translate_a/single?sl=<from>&tl=<to>&q=<phrase>   (Backend=Google)
+//   POST /translate {"q": ..., "source": ..., "target": ...}  (Backend=JsonPost)
+//
+// Point Capture2Text at it with, for example:
+//   [Translate]
+//   Backend=JsonPost
+//   Endpoint=http://localhost:5000/translate
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QTextStream>
+#include <QTimer>
+#include <QUrl>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+
+struct Connection
+{
+    int id;
+    QByteArray buffer;
+    QElapsedTimer sinceAccept;
+    int numRequests;
+};
+
+struct Request
+{
+    QByteArray method;
+    QUrl url;
+    QByteArray body;
+    bool keepAlive;
+};
+
+static QTextStream out(stdout);
+
+// Return the fake translation of phrase. Each line is tagged with the target language so
+// that line breaks survive the round trip and the result is easy to check.
+static QString fakeTranslate(const QString &phrase, const QString &to)
+{
+    QStringList lines = phrase.split('\n');
+
+    for(QString &line : lines)
+    {
+        line = QString("[%1] %2").arg(to, line);
+    }
+
+    return lines.join('\n');
+}
+
+// Decode a form encoded query string, where '+' stands for a space.
+static QHash<QString, QString> parseQuery(const QString &query)
+{
+    QHash<QString, QString> items;
+
+    for(const QString &item : query.split('&', QString::SkipEmptyParts))
+    {
+        QString key = item.section('=', 0, 0);
+        QString value = item.section('=', 1);
+        value.replace('+', ' ');
+        items.insert(QUrl::fromPercentEncoding(key.toUtf8()), QUrl::fromPercentEncoding(value.toUtf8()));
+    }
+
+    return items;
+}
+
+// Extract the first complete request from buffer. Returns false if more data is needed.
+static bool takeRequest(QByteArray &buffer, Request *request)
+{
+    int headerEnd = buffer.indexOf("\r\n\r\n");
+
+    if(headerEnd < 0)
+    {
+        return false;
+    }
+
+    QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    QList<QByteArray> requestLine = lines[0].trimmed().split(' ');
+    int contentLength = 0;
+    bool keepAlive = requestLine.value(2) != "HTTP/1.0";
+
+    for(int i = 1; i < lines.size(); i++)
+    {
+        QByteArray name = lines[i].section(':', 0, 0).trimmed().toLower();
+        QByteArray value = lines[i].section(':', 1).trimmed();
+
+        if(name == "content-length")
+        {
+            contentLength = value.toInt();
+        }
+        else if(name == "connection")
+        {
+            keepAlive = value.toLower() != "close";
+        }
+    }
+
+    int requestSize = headerEnd + 4 + contentLength;
+
+    if(buffer.size() < requestSize)
+    {
+        return false;
+    }
+
+    request->method = requestLine.value(0);
+    request->url = QUrl::fromEncoded(requestLine.value(1));
+    request->body = buffer.mid(headerEnd + 4, contentLength);
+    request->keepAlive = keepAlive;
+
+    buffer.remove(0, requestSize);
+
+    return true;
+}
+
+static QByteArray createResponse(const Request &request, int *status)
+{
+    QString path = request.url.path();
+
+    if(request.method == "GET" && path == "/translate_a/single")
+    {
+        // Same shape as the Google reply: [[["<translation>","<phrase>",null,null,1]],null,"<from>"]
+        QHash<QString, QString> query = parseQuery(request.url.query(QUrl::FullyEncoded));
+        QString phrase = query.value("q");
+
+        QJsonArray segment;
+        segment << fakeTranslate(phrase, query.value("tl")) << phrase << QJsonValue() << QJsonValue() << 1;
+
+        QJsonArray reply;
+        reply << QJsonArray({ segment }) << QJsonValue() << query.value("sl");
+
+        *status = 200;
+        return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+    }
+    else if(request.method == "POST" && path == "/translate")
+    {
+        QJsonObject json = QJsonDocument::fromJson(request.body).object();
+
+        QJsonObject reply;
+        reply.insert("translatedText", fakeTranslate(json.value("q").toString(), json.value("target").toString()));
+
+        *status = 200;
+        return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+    }
+
+    *status = 404;
+    return QByteArray("{\"error\": \"Not found\"}");
+}
+
+static void sendResponse(QTcpSocket *socket, const Request &request)
+{
+    int status = 0;
+    QByteArray body = createResponse(request, &status);
+
+    QByteArray header = QString("HTTP/1.1 %1 %2\r\n"
+                                "Content-Type: application/json; charset=utf-8\r\n"
+                                "Content-Length: %3\r\n"
+                                "Connection: %4\r\n"
+                                "\r\n")
+            .arg(status)
+            .arg(status == 200 ? "OK" : "Not Found")
+            .arg(body.size())
+            .arg(request.keepAlive ? "keep-alive" : "close").toUtf8();
+
+    socket->write(header + body);
+
+    if(!request.keepAlive)
+    {
+        socket->disconnectFromHost();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("TranslateStandIn");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in translation server for testing and benchmarking Capture2Text.");
+    parser.addHelpOption();
+
+    QCommandLineOption portOption(QStringList() << "p" << "port",
+                                  "Port to listen on (default 5000).", "port", "5000");
+    QCommandLineOption delayOption(QStringList() << "d" << "delay",
+                                   "Delay every reply by this many milliseconds (default 0).", "ms", "0");
+    QCommandLineOption connectDelayOption(QStringList() << "c" << "connect-delay",
+                                          "Simulate connection setup cost: the first reply on a connection is not "
+                                          "sent until this many milliseconds after the connection was accepted (default 0).",
+                                          "ms", "0");
+    parser.addOption(portOption);
+    parser.addOption(delayOption);
+    parser.addOption(connectDelayOption);
+    parser.process(app);
+
+    int port = parser.value(portOption).toInt();
+    int delay = parser.value(delayOption).toInt();
+    int connectDelay = parser.value(connectDelayOption).toInt();
+
+    QTcpServer server;
+    QHash<QTcpSocket *, Connection> connections;
+    int nextConnectionId = 1;
+
+    if(!server.listen(QHostAddress::LocalHost, port))
+    {
+        QTextStream(stderr) << "Failed to listen on port " << port << ": " << server.errorString() << endl;
+        return 1;
+    }
+
+    out << "Listening on http://localhost:" << server.serverPort() << endl;
+
+    QObject::connect(&server, &QTcpServer::newConnection, [&]()
+    {
+        while(QTcpSocket *socket = server.nextPendingConnection())
+        {
+            Connection conn;
+            conn.id = nextConnectionId++;
+            conn.sinceAccept.start();
+            conn.numRequests = 0;
+            connections.insert(socket, conn);
+
+            out << "#" << conn.id << " connected" << endl;
+
+            QObject::connect(socket, &QTcpSocket::disconnected, [&connections, socket]()
+            {
+                out << "#" << connections[socket].id << " closed after "
+                    << connections[socket].numRequests << " request(s)" << endl;
+                connections.remove(socket);
+                socket->deleteLater();
+            });
+
+            QObject::connect(socket, &QTcpSocket::readyRead, [&connections, socket, delay, connectDelay]()
+            {
+                Connection &conn = connections[socket];
+                conn.buffer += socket->readAll();
+
+                Request request;
+
+                while(takeRequest(conn.buffer, &request))
+                {
+                    conn.numRequests++;
+
+                    // A request on a pre-warmed connection has already paid the connection delay
+                    int replyDelay = delay;
+
+                    if(conn.numRequests == 1)
+                    {
+                        replyDelay = qMax(replyDelay, connectDelay - (int)conn.sinceAccept.elapsed());
+                    }
+
+                    out << "#" << conn.id << " " << request.method << " " << request.url.path()
+                        << " request " << conn.numRequests
+                        << " at " << conn.sinceAccept.elapsed() << " ms after connect"
+                        << ", reply delay " << replyDelay << " ms" << endl;
+
+                    QPointer<QTcpSocket> guard(socket);
+
+                    QTimer::singleShot(replyDelay, [guard, request]()
+                    {
+                        if(guard)
+                        {
+                            sendResponse(guard, request);
+                        }
+                    });
+                }
+            });
+        }
+    });
+
+    return app.exec();
+}